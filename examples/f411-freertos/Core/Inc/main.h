@@ -68,13 +68,10 @@ void Error_Handler(void);
 /* USER CODE BEGIN Private defines */
 #define LEDS 64
 
+#define WS2812_RTOS // Frame handoff from tasks - ws2812_rtos.h
+
 #ifdef DEBUG
 #define DBG(...)    printf(__VA_ARGS__)
-
-void log(char *s) {
-
-}
-
 #else
 #define DBG(...)
 #endif
@@ -22,7 +22,9 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "ws2812.h"
+#include "ws2812_rtos.h"
+#include "ws2812_demos.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -64,7 +66,7 @@ const osThreadAttr_t ledTask_attributes = {
 osThreadId_t logTaskHandle;
 const osThreadAttr_t logTask_attributes = {
   .name = "logTask",
-  .stack_size = 128 * 4,
+  .stack_size = 512 * 4,
   .priority = (osPriority_t) osPriorityLow,
 };
 /* Definitions for logQueue */
@@ -73,7 +75,9 @@ const osMessageQueueAttr_t logQueue_attributes = {
   .name = "logQueue"
 };
 /* USER CODE BEGIN PV */
-
+WS2812_DECLARE(ws2812, LEDS); // The WS2812 panel handler - statically allocated
+WS2812_RTOS_DECLARE(rtos, LEDS); // Frame handoff from the led task to the DMA
+ws2812_rtos_renderTypeDef render;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -93,6 +97,29 @@ void StartLogTask(void *argument);
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
 
+// Done sending first half of the DMA buffer - this can now safely be updated
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
+
+    ws2812_tim_half_callback(htim);
+
+}
+
+// Done sending the second half of the DMA buffer - this can now be safely updated
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
+
+    ws2812_tim_full_callback(htim);
+
+}
+
+// Draw the next frame - called by the render task
+static void led_render(ws2812_handleTypeDef *ws2812, uint32_t frame) {
+
+    UNUSED(frame);
+
+    ws2812_demos_tick(ws2812);
+
+}
+
 int _write(int fd, char *ptr, int len) {
     HAL_StatusTypeDef hstatus;
 
@@ -143,6 +170,11 @@ int main(void)
 
     DBG("\n\n\n\n--------\nStarting\n");
 
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+    WS2812_RTOS_INIT_STATIC(rtos, &ws2812);
+
+    ws2812_demos_set(&ws2812, 1);
+
   /* USER CODE END 2 */
 
   /* Init scheduler */
@@ -162,7 +194,7 @@ int main(void)
 
   /* Create the queue(s) */
   /* creation of logQueue */
-  logQueueHandle = osMessageQueueNew (16, sizeof(uint132_t), &logQueue_attributes);
+  logQueueHandle = osMessageQueueNew (16, sizeof(ws2812_rtos_statsTypeDef), &logQueue_attributes);
 
   /* USER CODE BEGIN RTOS_QUEUES */
     /* add queues, ... */
@@ -391,7 +423,8 @@ void StartDefaultTask(void *argument)
   /* USER CODE BEGIN 5 */
     /* Infinite loop */
     for (;;) {
-        osDelay(1);
+        HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
+        osDelay(500);
     }
   /* USER CODE END 5 */
 }
@@ -406,11 +439,9 @@ void StartDefaultTask(void *argument)
 void StartLedTask(void *argument)
 {
   /* USER CODE BEGIN StartLedTask */
-    /* Infinite loop */
-    for (;;) {
-        HAL_GPIO_TogglePin(LED_GPIO_Port, LED_Pin);
-        osDelay(500);
-    }
+    // Render 50 frames a second and report how that goes to the log task
+    ws2812_rtos_render_init(&render, &rtos, led_render, 50, (QueueHandle_t) logQueueHandle);
+    ws2812_rtos_render_task(&render);
   /* USER CODE END StartLedTask */
 }
 
@@ -424,22 +455,15 @@ void StartLedTask(void *argument)
 void StartLogTask(void *argument)
 {
   /* USER CODE BEGIN StartLogTask */
-  /* Infinite loop */
-  for(;;) {
+    ws2812_rtos_statsTypeDef stats;
 
-
-
-      // Assign delay based on message in queue
-      status = osMessageQueueGet(logQueueHandle, &msg, NULL, 0);
-
-      // If message was received, update delay
-      if ( status == osOK )
-      {
-        delay = msg;
-      }
-
-    osDelay(1);
-  }
+    /* Infinite loop */
+    for (;;) {
+        if (osMessageQueueGet(logQueueHandle, &stats, NULL, osWaitForever) == osOK) {
+            DBG("Render %lu.%02lu fps (%lu late) jitter max %lu avg %lu ms\n", stats.fps / 100, stats.fps % 100,
+                    stats.skipped, stats.jitter_max, stats.frames ? stats.jitter_sum / stats.frames : 0);
+        }
+    }
   /* USER CODE END StartLogTask */
 }
 
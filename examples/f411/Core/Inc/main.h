@@ -65,6 +65,9 @@ void Error_Handler(void);
 #define LED_GPIO_Port GPIOC
 #define BTN_Pin GPIO_PIN_0
 #define BTN_GPIO_Port GPIOA
+#define BTN_EXTI_IRQn EXTI0_IRQn
+#define LED_PWR_Pin GPIO_PIN_0
+#define LED_PWR_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
 #define LEDS 64
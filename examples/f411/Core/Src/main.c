@@ -48,7 +48,9 @@ UART_HandleTypeDef huart1;
 
 /* USER CODE BEGIN PV */
 
-ws2812_handleTypeDef ws2812; // The WS2812 panel handler
+WS2812_DECLARE(ws2812, LEDS); // The WS2812 panel handler - statically allocated
+
+volatile uint8_t btn_pressed = 0;
 
 /* USER CODE END PV */
 
@@ -80,17 +82,25 @@ int _write(int fd, char *ptr, int len) {
 // Done sending first half of the DMA buffer - this can now safely be updated
 void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
 
-    if (htim->Instance == TIM4) {
-        ws2812_update_buffer(&ws2812, &ws2812.dma_buffer[0]);
-    }
+    ws2812_tim_half_callback(htim);
 
 }
 
 // Done sending the second half of the DMA buffer - this can now be safely updated
 void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
 
-    if (htim->Instance == TIM4) {
-        ws2812_update_buffer(&ws2812, &ws2812.dma_buffer[BUFFER_SIZE]);
+    ws2812_tim_full_callback(htim);
+
+}
+
+// The button starts and stops the demo - and wakes us up from STOP
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+
+    static uint32_t last_press = 0;
+
+    if (GPIO_Pin == BTN_Pin && uwTick - last_press > 200) { // Ignore the bounces
+        btn_pressed = 1;
+        last_press = uwTick;
     }
 
 }
@@ -133,7 +143,9 @@ int main(void)
 
     printf("WS2812 Demo\n");
 
-    ws2812_init(&ws2812, &htim4, TIM_CHANNEL_1, 64);
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+    ws2812_set_idle_stop(&ws2812, 1); // No DMA interrupts while nothing changes
+    ws2812_set_power_pin(&ws2812, LED_PWR_GPIO_Port, LED_PWR_Pin, GPIO_PIN_SET, 1000); // Led power off after a second dark
 
     ws2812_demos_set(&ws2812, 1);
 
@@ -143,11 +155,21 @@ int main(void)
     /* USER CODE BEGIN WHILE */
 
     uint32_t now = 0, next_blink = 500, next_tick = 1000, loop_count = 0;
+    uint8_t demo = 1;
 
     while (1) {
 
         now = uwTick;
 
+        if (btn_pressed) {
+            btn_pressed = 0;
+            demo = !demo;
+            ws2812_demos_set(&ws2812, demo ? WS2812_DEMO_LINE : WS2812_DEMO_NONE);
+            if (!demo) {
+                zeroLedValues(&ws2812); // Dark - the power goes off a second after the string stops
+            }
+        }
+
         if (!(now % 10)) { // Just call every 10th loop
             ws2812_demos_tick(&ws2812);
         }
@@ -158,12 +180,28 @@ int main(void)
         }
 
         if (now >= next_tick) {
-            printf("Tick %lu (count = %lu dma = %lu dat = %lu)\n", now / 1000, loop_count, ws2812.dma_cbs, ws2812.dat_cbs);
+            printf("Tick %lu (count = %lu dma = %lu dat = %lu power = %u)\n", now / 1000, loop_count, ws2812.dma_cbs, ws2812.dat_cbs, ws2812_power_state_all());
             loop_count = 0;
             next_tick = now + 1000;
         }
 
-        ++loop_count;
+        ws2812_power_tick(&ws2812);
+
+        ++loop_count; // Now counts wake ups
+
+        if (!demo && ws2812_power_state_all() == WS2812_POWER_OFF && ws2812_next_activity_all() == WS2812_NEVER) {
+            // Dark, stopped and the led power off - nothing to do until the button is pressed.
+            // STOP keeps the ram and registers but stops the clocks, so set them up again after.
+            printf("Stop until the button is pressed\n");
+            HAL_SuspendTick();
+            HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+            SystemClock_Config();
+            HAL_ResumeTick();
+        } else {
+            // Sleep until the next interrupt - SysTick at the latest.  The DMA keeps running
+            // and a pending power switch is counted in ms, so no deeper than this.
+            HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+        }
 
         /* USER CODE END WHILE */
 
@@ -345,6 +383,9 @@ static void MX_GPIO_Init(void)
     /*Configure GPIO pin Output Level */
     HAL_GPIO_WritePin(LED_GPIO_Port, LED_Pin, GPIO_PIN_SET);
 
+    /*Configure GPIO pin Output Level */
+    HAL_GPIO_WritePin(LED_PWR_GPIO_Port, LED_PWR_Pin, GPIO_PIN_SET);
+
     /*Configure GPIO pin : LED_Pin */
     GPIO_InitStruct.Pin = LED_Pin;
     GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
@@ -358,6 +399,17 @@ static void MX_GPIO_Init(void)
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     HAL_GPIO_Init(BTN_GPIO_Port, &GPIO_InitStruct);
 
+    /*Configure GPIO pin : LED_PWR_Pin */
+    GPIO_InitStruct.Pin = LED_PWR_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+    HAL_GPIO_Init(LED_PWR_GPIO_Port, &GPIO_InitStruct);
+
+    /* EXTI interrupt init*/
+    HAL_NVIC_SetPriority(EXTI0_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(EXTI0_IRQn);
+
     /* USER CODE BEGIN MX_GPIO_Init_2 */
     /* USER CODE END MX_GPIO_Init_2 */
 }
@@ -0,0 +1,311 @@
+/**
+ ******************************************************************************
+ * @file           : color_check.c
+ * @brief          : Compare the generated color table with the hand-written one
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * color_value used to be written out by hand.  Build with a LED_CNT of your
+ * own (make check does 89 and 125) to see COLOR_VALUE_TABLE still gives the
+ * same table.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+#include "color_values.h"
+
+// The table as it was in color_values.c
+static const ws2812_dmaTypeDef color_value_old[256][8] = {
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF, LED_ON },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_OFF },
+        { LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON, LED_ON }
+};
+
+int main(void) {
+
+    uint16_t wrong = 0;
+    for (uint16_t v = 0; v < 256; v++) {
+        if (memcmp(color_value[v], color_value_old[v], sizeof(color_value[v])) != 0) {
+            if (wrong++ == 0) {
+                fprintf(stderr, "FAIL: color_value[%u] differs from the hand-written table\n", v);
+            }
+        }
+    }
+
+    printf("LED_CNT %u, off %u, on %u: %u of 256 rows differ\n", LED_CNT, LED_OFF, LED_ON, wrong);
+
+    return wrong > 0;
+
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,103 @@
+/**
+ ******************************************************************************
+ * @file           : encode.c
+ * @brief          : Encode raw frames into a compressed ws2812_stream
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * ws2812_encode [-p] leds < frames.rgb > stream.bin
+ *
+ * Reads raw frames of leds * 3 bytes (r, g, b) and writes them as TPM2 delta
+ * packets, each against the frame before.  With -p the colors used go into a
+ * palette first - when there are no more than 256 of them.  Sizes compared to
+ * Adalight go to stderr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+
+#include "ws2812_stream.h"
+#include "stream_encode.h"
+
+int main(int argc, char *argv[]) {
+
+    int use_palette = argc > 2 && strcmp(argv[1], "-p") == 0;
+    if (argc < 2 + use_palette || atoi(argv[1 + use_palette]) <= 0) {
+        fprintf(stderr, "usage: %s [-p] leds < frames.rgb > stream.bin\n", argv[0]);
+        return 1;
+    }
+
+    uint16_t leds = atoi(argv[1 + use_palette]);
+    uint32_t size = leds * 3;
+
+    // All of it - palette needs to see every frame first
+    uint8_t *frames = NULL;
+    uint32_t cnt = 0;
+    size_t len;
+    do {
+        frames = realloc(frames, (cnt + 1) * size);
+        len = fread(&frames[cnt * size], 1, size, stdin);
+        cnt += len == size;
+    } while (len == size);
+
+    static uint8_t palette[256 * 3];
+    uint16_t entries = 0;
+    if (use_palette) {
+        for (uint32_t i = 0; i < cnt * leds && entries <= 256; i++) {
+            uint16_t e = 0;
+            while (e < entries && memcmp(&palette[e * 3], &frames[i * 3], 3) != 0) {
+                e++;
+            }
+            if (e == entries && entries++ < 256) {
+                memcpy(&palette[e * 3], &frames[i * 3], 3);
+            }
+        }
+        if (entries > 256) {
+            fprintf(stderr, "more than 256 colors - no palette\n");
+            entries = 0;
+        }
+    }
+
+    uint8_t *out = malloc(STREAM_ENCODE_MAX(leds) + 5 + 256 * 3);
+    uint64_t total = 0;
+
+    if (entries > 0) {
+        len = stream_encode_palette(out, palette, 0, entries);
+        fwrite(out, 1, len, stdout);
+        total += len;
+    }
+
+    for (uint32_t f = 0; f < cnt; f++) {
+        len = stream_encode_delta(out, &frames[f * size], f > 0 ? &frames[(f - 1) * size] : NULL, leds, palette, entries);
+        fwrite(out, 1, len, stdout);
+        total += len;
+    }
+
+    uint64_t raw = (uint64_t) cnt * (6 + size);
+    fprintf(stderr, "%lu frames, %llu bytes, Adalight %llu bytes (%.1fx)\n", (unsigned long) cnt, (unsigned long long) total, (unsigned long long) raw,
+            total > 0 ? (double) raw / total : 0.0);
+
+    free(out);
+    free(frames);
+
+    return 0;
+
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
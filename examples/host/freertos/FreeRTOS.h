@@ -0,0 +1,38 @@
+/**
+ ******************************************************************************
+ * @file           : FreeRTOS.h
+ * @brief          : Just enough of FreeRTOS for building ws2812_rtos on a host
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+// The tasks and the scheduler are played by rtos_check.c - one tick is 1 ms of simulated time
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+
+#define pdFALSE ((BaseType_t) 0)
+#define pdTRUE ((BaseType_t) 1)
+
+#define configTICK_RATE_HZ 1000
+
+#define portYIELD_FROM_ISR(woken) ((void) (woken))
+
+#endif /* FREERTOS_H */
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,30 @@
+/**
+ ******************************************************************************
+ * @file           : queue.h
+ * @brief          : Queue functions used by ws2812_rtos - implemented by rtos_check.c
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout);
+
+#endif /* QUEUE_H */
+/*
+ * vim: ts=4 nowrap
+ */
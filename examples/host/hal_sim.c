@@ -0,0 +1,262 @@
+/**
+ ******************************************************************************
+ * @file           : hal_sim.c
+ * @brief          : Simulated timer and DMA HAL for building the library on a host
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+
+#define SIM_CHANNELS 8
+
+typedef struct {
+    TIM_HandleTypeDef *htim;
+    uint32_t channel;
+    DMA_HandleTypeDef dma;                  // Used when the timer handle has none
+    DMA_HandleTypeDef *hdma;
+    const ws2812_dmaTypeDef *data;
+    uint16_t length;
+    uint16_t pos;
+    uint8_t running;
+    uint8_t pending;                        // Callback held back - DMA_IT_HT or DMA_IT_TC
+    uint32_t pending_periods;
+    uint16_t trace[SIM_TRACE_SIZE];
+    uint32_t trace_len;
+} sim_channelTypeDef;
+
+static sim_channelTypeDef sim_channels[SIM_CHANNELS];
+static uint64_t sim_periods = 0;
+static uint32_t sim_delay_periods = 0;
+
+uint32_t sim_primask = 0;
+void (*sim_unmask)(void) = NULL;
+
+static sim_channelTypeDef* sim_find(TIM_HandleTypeDef *htim, uint32_t channel, uint8_t add) {
+    for (uint8_t i = 0; i < SIM_CHANNELS; i++) {
+        sim_channelTypeDef *ch = &sim_channels[i];
+        if (ch->htim == htim && ch->channel == channel) {
+            return ch;
+        }
+    }
+    for (uint8_t i = 0; add && i < SIM_CHANNELS; i++) {
+        sim_channelTypeDef *ch = &sim_channels[i];
+        if (ch->htim == NULL) {
+            ch->htim = htim;
+            ch->channel = channel;
+            return ch;
+        }
+    }
+    return NULL;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, const uint32_t *pData, uint16_t Length) {
+
+    sim_channelTypeDef *ch = sim_find(htim, Channel, 1);
+    if (ch == NULL) {
+        return HAL_ERROR;
+    }
+    if (ch->running) {
+        return HAL_BUSY;
+    }
+
+    uint16_t id = TIM_DMA_ID_CC1 + Channel / 4;
+    if (htim->hdma[id] == NULL) {
+        htim->hdma[id] = &ch->dma;
+    }
+
+    ch->hdma = htim->hdma[id];
+    ch->hdma->Instance = &ch->hdma->stream;
+    ch->hdma->Instance->NDTR = Length;
+    ch->hdma->it = DMA_IT_HT | DMA_IT_TC;
+    ch->data = (const ws2812_dmaTypeDef*) pData;
+    ch->length = Length;
+    ch->pos = 0;
+    ch->running = 1;
+
+    return HAL_OK;
+
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t Channel) {
+    sim_channelTypeDef *ch = sim_find(htim, Channel, 0);
+    if (ch != NULL) {
+        ch->running = 0;
+    }
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+    return sim_periods * SIM_PERIOD_NS / 1000000;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+    if (PinState == GPIO_PIN_SET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~GPIO_Pin;
+    }
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size) {
+    huart->rx_buffer = pData;
+    huart->rx_size = Size;
+    huart->rx_pos = 0;
+    huart->receiving = 1;
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    (void) huart;
+    (void) Size;
+}
+
+__attribute__((weak)) void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
+    (void) htim;
+}
+
+__attribute__((weak)) void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
+    (void) htim;
+}
+
+static void sim_callback(sim_channelTypeDef *ch, uint8_t it) {
+    ch->htim->Channel = (HAL_TIM_ActiveChannel) (HAL_TIM_ACTIVE_CHANNEL_1 << (ch->channel / 4));
+    if (it == DMA_IT_HT) {
+        HAL_TIM_PWM_PulseFinishedHalfCpltCallback(ch->htim);
+    } else {
+        HAL_TIM_PWM_PulseFinishedCallback(ch->htim);
+    }
+    ch->htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+}
+
+/*
+ * Every period each running DMA moves the next value to the compare register
+ * (recorded in the trace) and calls back at the half and the wrap around, just
+ * like a circular DMA does.  The callbacks run before the next period so the
+ * library always makes its deadline - timing problems show up as wrong data only
+ * when the library writes a half that has not been sent yet.
+ */
+void sim_run(uint32_t periods) {
+
+    while (periods--) {
+
+        for (uint8_t i = 0; i < SIM_CHANNELS; i++) {
+
+            sim_channelTypeDef *ch = &sim_channels[i];
+            if (ch->htim == NULL) {
+                continue;
+            }
+
+            if (!ch->running) { // Output stays low - traced so gaps keep their real length
+                if (ch->trace_len < SIM_TRACE_SIZE) {
+                    ch->trace[ch->trace_len++] = 0;
+                }
+                continue;
+            }
+
+            if (ch->trace_len < SIM_TRACE_SIZE) {
+                ch->trace[ch->trace_len++] = ch->data[ch->pos];
+            }
+
+            ++ch->pos;
+            if (ch->pos == ch->length) {
+                ch->pos = 0;
+            }
+            ch->hdma->Instance->NDTR = ch->length - ch->pos;
+
+            if (ch->pending && --ch->pending_periods == 0) {
+                uint8_t it = ch->pending;
+                ch->pending = 0;
+                sim_callback(ch, it);
+            }
+
+            uint8_t it = 0;
+            if (ch->pos == ch->length / 2) {
+                it = ch->hdma->it & DMA_IT_HT;
+            } else if (ch->pos == 0) {
+                it = ch->hdma->it & DMA_IT_TC;
+            }
+
+            if (it && ch->pending) { // Both flags set by the time the interrupt runs - handled in one go
+                uint8_t pending = ch->pending;
+                ch->pending = 0;
+                sim_callback(ch, pending);
+                sim_callback(ch, it);
+            } else if (it && sim_delay_periods > 0) {
+                ch->pending = it;
+                ch->pending_periods = sim_delay_periods;
+                sim_delay_periods = 0;
+            } else if (it) {
+                sim_callback(ch, it);
+            }
+
+        }
+
+        ++sim_periods;
+
+    }
+
+}
+
+void sim_delay(uint32_t periods) {
+    sim_delay_periods = periods;
+}
+
+uint64_t sim_time(void) {
+    return sim_periods * SIM_PERIOD_NS;
+}
+
+void sim_uart_receive(UART_HandleTypeDef *huart, const uint8_t *data, uint32_t len) {
+
+    if (!huart->receiving) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        huart->rx_buffer[huart->rx_pos++] = data[i];
+        if (huart->rx_pos == huart->rx_size / 2) { // Half transfer
+            HAL_UARTEx_RxEventCallback(huart, huart->rx_pos);
+        } else if (huart->rx_pos == huart->rx_size) { // Transfer complete - circular
+            HAL_UARTEx_RxEventCallback(huart, huart->rx_pos);
+            huart->rx_pos = 0;
+        }
+    }
+
+    if (len > 0 && huart->rx_pos != 0) { // Idle line
+        HAL_UARTEx_RxEventCallback(huart, huart->rx_pos);
+    }
+
+}
+
+const uint16_t* sim_trace(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t *len) {
+    sim_channelTypeDef *ch = sim_find(htim, channel, 0);
+    if (ch == NULL) {
+        *len = 0;
+        return NULL;
+    }
+    *len = ch->trace_len;
+    return ch->trace;
+}
+
+void sim_trace_clear(void) {
+    for (uint8_t i = 0; i < SIM_CHANNELS; i++) {
+        sim_channels[i].trace_len = 0;
+    }
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,160 @@
+/**
+ ******************************************************************************
+ * @file           : hal_sim.h
+ * @brief          : Simulated timer and DMA HAL for building the library on a host
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef HAL_SIM_H_
+#define HAL_SIM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Just enough of the STM32 HAL for the library.  DMA handles look like the F4
+// stream DMA - a PWM DMA runs circular, one transfer per PWM period, with the
+// half and full complete callbacks called from sim_run.
+
+typedef enum {
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_TIM_ACTIVE_CHANNEL_1 = 0x01U,
+    HAL_TIM_ACTIVE_CHANNEL_2 = 0x02U,
+    HAL_TIM_ACTIVE_CHANNEL_3 = 0x04U,
+    HAL_TIM_ACTIVE_CHANNEL_4 = 0x08U,
+    HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U
+} HAL_TIM_ActiveChannel;
+
+typedef struct {
+    volatile uint32_t NDTR;                 // Transfers left before wrapping around
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    DMA_Stream_TypeDef *Instance;
+    DMA_Stream_TypeDef stream;
+    uint32_t it;                            // Enabled interrupts
+} DMA_HandleTypeDef;
+
+typedef struct {
+    void *Instance;
+    DMA_HandleTypeDef *hdma[7];             // Filled in by HAL_TIM_PWM_Start_DMA when left NULL
+    HAL_TIM_ActiveChannel Channel;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    volatile uint32_t ODR;
+    volatile uint32_t BSRR;
+} GPIO_TypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+#define __weak __attribute__((weak))
+#define UNUSED(X) (void)X
+
+// Receives into a circular buffer like a circular DMA with idle line detection
+typedef struct {
+    uint8_t *rx_buffer;
+    uint16_t rx_size;
+    uint16_t rx_pos;                        // Next byte in rx_buffer
+    uint8_t receiving;
+} UART_HandleTypeDef;
+
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+
+#define TIM_DMA_ID_UPDATE ((uint16_t) 0x0000)
+#define TIM_DMA_ID_CC1 ((uint16_t) 0x0001)
+#define TIM_DMA_ID_CC2 ((uint16_t) 0x0002)
+#define TIM_DMA_ID_CC3 ((uint16_t) 0x0003)
+#define TIM_DMA_ID_CC4 ((uint16_t) 0x0004)
+
+#define DMA_IT_HT 0x00000008U
+#define DMA_IT_TC 0x00000010U
+
+#define __HAL_DMA_DISABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->it &= ~(__INTERRUPT__))
+#define __HAL_DMA_ENABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->it |= (__INTERRUPT__))
+#define __HAL_DMA_GET_COUNTER(__HANDLE__) ((__HANDLE__)->Instance->NDTR)
+
+// No exclusive access as on a Cortex-M0 - ws2812_rtos swaps under PRIMASK
+#define __CORTEX_M 0
+
+// Nothing else runs while a callback does.  sim_unmask, when set, is called
+// whenever PRIMASK is cleared - where a callback that came in while it was set
+// would run first.
+extern uint32_t sim_primask;
+extern void (*sim_unmask)(void);
+
+static inline uint32_t __get_PRIMASK(void) {
+    return sim_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t priMask) {
+    sim_primask = priMask;
+    if (priMask == 0 && sim_unmask != NULL) {
+        sim_unmask();
+    }
+}
+
+static inline void __disable_irq(void) {
+    sim_primask = 1;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start_DMA(TIM_HandleTypeDef *htim, uint32_t Channel, const uint32_t *pData, uint16_t Length);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop_DMA(TIM_HandleTypeDef *htim, uint32_t Channel);
+uint32_t HAL_GetTick(void);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim);
+
+// PWM period in ns - 800 kHz
+#define SIM_PERIOD_NS 1250
+
+// Compare values recorded per timer channel
+#define SIM_TRACE_SIZE 65536
+
+// Run every started PWM DMA for a number of PWM periods
+void sim_run(uint32_t periods);
+
+// Hold back the next callback for a number of periods - like a higher priority interrupt would
+void sim_delay(uint32_t periods);
+
+// Simulated time since start in ns
+uint64_t sim_time(void);
+
+// Receive bytes followed by an idle line - calls HAL_UARTEx_RxEventCallback at
+// the half and end of the buffer and at the end like the HAL does
+void sim_uart_receive(UART_HandleTypeDef *huart, const uint8_t *data, uint32_t len);
+
+// Compare values sent on a timer channel since the last sim_trace_clear - at most SIM_TRACE_SIZE.
+// Zero for every period the channel was stopped.
+const uint16_t* sim_trace(TIM_HandleTypeDef *htim, uint32_t channel, uint32_t *len);
+void sim_trace_clear(void);
+
+#endif /* HAL_SIM_H_ */
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,1015 @@
+/**
+ ******************************************************************************
+ * @file           : main.c
+ * @brief          : Host simulation of the ws2812 library
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Runs the library against the simulated timer and DMA in hal_sim.c.  Prints
+ * the state machine transitions, decodes the compare values sent into frames
+ * and compares them with the led values, then measures how long encoding and
+ * decoding take on the host.  Given a logic analyzer capture (csv) it decodes
+ * that instead.  With -t file it writes the compare values of a fixed sequence
+ * of frames, which must not change with WS2812_LEDS_PER_BUFFER.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+#include "color_values.h"
+#include "gamma_values.h"
+#include "ws2812_verify.h"
+#include "ws2812_stream.h"
+#include "ws2812_transpose.h"
+#include "stream_encode.h"
+
+TIM_HandleTypeDef htim4;
+UART_HandleTypeDef huart1;
+
+WS2812_DECLARE(ws2812, LEDS);
+
+uint16_t value16[LEDS * 4];
+uint8_t error[LEDS * 4];
+
+uint8_t frame[LEDS * 4];
+ws2812_verifyTypeDef verify;
+
+GPIO_TypeDef led_power;
+
+ws2812_streamTypeDef stream;
+uint8_t stream_data[8 + LEDS * 3];
+
+ws2812_dmaTypeDef frame_buffer[WS2812_FRAME_BUFFER_SIZE(LEDS)];
+
+uint8_t palette_index[LEDS / 2];
+uint8_t palette[WS2812_PALETTE_ENTRIES(4) * 4];
+
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
+    ws2812_tim_half_callback(htim);
+}
+
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
+    ws2812_tim_full_callback(htim);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    ws2812_stream_rx_callback(huart, Size);
+}
+
+// Periods to send a frame of leds including the reset before it and the halves in flight
+#define SEND_PERIODS(bits) (LEDS * (bits) + (LED_RESET_HALVES + 5) * WS2812_MAX_BUFFER_SIZE)
+
+static const char *state_names[] = { "LED_RES", "LED_IDL", "LED_DAT" };
+
+// Checks failed so far - the exit code is nonzero when there are any
+static uint32_t failures = 0;
+
+static void check(int ok, const char *format, ...) {
+    if (!ok) {
+        va_list args;
+        va_start(args, format);
+        fprintf(stderr, "FAIL at %.2f us: ", sim_time() / 1000.0);
+        vfprintf(stderr, format, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+        ++failures;
+    }
+}
+
+// State changes the DMA callbacks may make - a reset is followed by idle or data, data by a reset
+static int transition_ok(ws2812_stateTypeDef from, ws2812_stateTypeDef to) {
+    return (from == LED_RES && (to == LED_IDL || to == LED_DAT)) || (from == LED_IDL && to == LED_DAT) || (from == LED_DAT && to == LED_RES);
+}
+
+// Frames started and not latched yet in order, with the led values they went out with
+typedef struct {
+    uint16_t leds;                          // 0 when cut short by an underrun
+    uint8_t ended;                          // Values taken when the frame ended
+    uint8_t dithered;                       // Started with value16 - no two such frames alike
+    uint8_t values[LEDS * 4];
+} frame_sentTypeDef;
+
+#define FRAMES_MAX 16
+static frame_sentTypeDef frames_sent[FRAMES_MAX];
+static uint8_t frames_head = 0, frames_tail = 0;
+static ws2812_stateTypeDef frame_state = LED_RES;
+static uint32_t frame_underruns = 0;
+static uint32_t frame_bits = 0;             // Bits of the last frame latched
+
+// Dithered frames summed up per led byte
+static uint32_t dither_sum[LEDS * 4];
+static uint32_t dither_frames = 0;
+
+// Led values as sent - palette colors looked up in palette mode, brightness and gamma applied
+static void led_values(uint8_t *values) {
+    if (ws2812.index != NULL) {
+        for (uint16_t led = 0; led < ws2812.leds; led++) {
+            uint8_t entry = ws2812.index_bits == 8 ? ws2812.index[led] : (ws2812.index[led / 2] >> (led % 2 * 4)) & 0x0f;
+            memcpy(&values[led * ws2812.bpp], &ws2812.palette[entry * ws2812.bpp], ws2812.bpp);
+        }
+    } else {
+        memcpy(values, ws2812.front, ws2812.leds * ws2812.bpp);
+    }
+    if (ws2812.use_lut) {
+        for (uint32_t i = 0; i < ws2812.leds * ws2812.bpp; i++) {
+            values[i] = ws2812.lut[values[i]];
+        }
+    }
+}
+
+// Frame buffer mode - every pass sent once the leds are up is a frame with the values last encoded
+static uint32_t fb_enc_frames = 0, fb_dma_cbs = 0;
+static uint8_t fb_values[LEDS * 4];
+
+static void track_frame_buffer(void) {
+    if (ws2812.enc_frames != fb_enc_frames) {
+        led_values(fb_values);
+    }
+    if (ws2812.zero_frames == 0 && !ws2812.stopped && (ws2812.enc_frames != fb_enc_frames || ws2812.dma_cbs != fb_dma_cbs)) {
+        check((uint8_t) (frames_head - frames_tail) < FRAMES_MAX, "too many frames in flight");
+        frame_sentTypeDef *last = &frames_sent[frames_head++ % FRAMES_MAX];
+        last->leds = ws2812.leds;
+        last->ended = 1;
+        last->dithered = 0;
+        memcpy(last->values, fb_values, sizeof(fb_values));
+    }
+    fb_enc_frames = ws2812.enc_frames;
+    fb_dma_cbs = ws2812.dma_cbs;
+}
+
+// Note frames starting and ending and underruns since the last call - frames restarted outside run() included
+static void track_frames(void) {
+    if (ws2812.frame_buffer != NULL) {
+        track_frame_buffer();
+        return;
+    }
+    frame_sentTypeDef *last = &frames_sent[(uint8_t) (frames_head - 1) % FRAMES_MAX];
+    if (ws2812.led_state == LED_DAT && frame_state != LED_DAT) {
+        check((uint8_t) (frames_head - frames_tail) < FRAMES_MAX, "too many frames in flight");
+        last = &frames_sent[frames_head++ % FRAMES_MAX];
+        last->leds = ws2812.frame_leds;
+        last->ended = 0;
+        last->dithered = ws2812.value16 != NULL;
+    } else if (ws2812.led_state != LED_DAT && frame_state == LED_DAT && frames_head != frames_tail) {
+        led_values(last->values); // Changes from here on go into the next frame
+        last->ended = 1;
+    }
+    if (ws2812.underruns != frame_underruns && frames_head != frames_tail) {
+        last->leds = 0;
+    }
+    frame_state = ws2812.led_state;
+    frame_underruns = ws2812.underruns;
+}
+
+// Run the simulation printing and checking every state change
+static void run(uint32_t periods) {
+    ws2812_stateTypeDef state = ws2812.led_state;
+    track_frames();
+    while (periods--) {
+        sim_run(1);
+        track_frames();
+        if (ws2812.led_state != state) {
+            printf("%10.2f us  %s -> %s\n", sim_time() / 1000.0, state_names[state], state_names[ws2812.led_state]);
+            check(transition_ok(state, ws2812.led_state), "%s -> %s", state_names[state], state_names[ws2812.led_state]);
+            state = ws2812.led_state;
+        }
+    }
+}
+
+// Refreshed back to back - run on into the reset between two frames so no frame is split between two traces
+static void run_to_reset(uint32_t periods) {
+    uint32_t len;
+    run(periods);
+    while (sim_trace(&htim4, TIM_CHANNEL_1, &len)[len - 1] != 0) { // Only resets and idle go out as 0
+        run(1);
+    }
+}
+
+// Print every frame the leds latch and compare it with the led values - exactly the leds the frame was started with
+static void latched(ws2812_verifyTypeDef *verify, uint32_t bits) {
+    if (frames_head == frames_tail) {
+        check(0, "frame %lu was never started", (unsigned long) verify->frames);
+        return;
+    }
+    frame_sentTypeDef *sent = &frames_sent[frames_tail++ % FRAMES_MAX];
+    frame_bits = bits;
+    if (sent->leds == 0) { // Whatever went out before the underrun was noticed - the frame is sent again
+        printf("frame %lu: %lu bits, cut short by an underrun\n", (unsigned long) verify->frames, (unsigned long) bits);
+        return;
+    }
+    if (!sent->ended) { // Still being sent when the trace ended
+        led_values(sent->values);
+    }
+    if (sent->dithered) { // Only the average of dithered frames is known
+        check(bits == sent->leds * ws2812.bpp * 8, "dithered frame %lu of %lu bits", (unsigned long) verify->frames, (unsigned long) bits);
+        for (uint32_t i = 0; i < bits / 8; i++) {
+            dither_sum[i] += verify->frame[i];
+        }
+        dither_frames++;
+        return;
+    }
+    uint32_t leds = bits / 8 / ws2812.bpp;
+    uint8_t ok = bits == sent->leds * ws2812.bpp * 8 && memcmp(verify->frame, sent->values, bits / 8) == 0;
+    printf("frame %lu: %lu leds, led 0 = %02x %02x %02x - %s\n", (unsigned long) verify->frames, (unsigned long) leds,
+            verify->frame[0], verify->frame[1], verify->frame[2], ok ? "matches" : "differs");
+    check(ok, "frame %lu differs from the led values", (unsigned long) verify->frames);
+}
+
+// Periods low between the last pulse sent and the next - the shortest between two frames
+static uint32_t low_periods = 0;
+static uint32_t shortest_reset = UINT32_MAX;
+static uint8_t pulse_seen = 0;
+
+// Decode the compare values sent since last time like the leds would - at least one frame is expected
+static void decode(void) {
+
+    uint32_t len;
+    const uint16_t *ccr = sim_trace(&htim4, TIM_CHANNEL_1, &len);
+    uint32_t frames = verify.frames;
+
+    for (uint32_t i = 0; i < len; i++) { // No low between bits lasts a whole period
+        if (ccr[i] == 0) {
+            ++low_periods;
+        } else {
+            if (pulse_seen && low_periods > 0 && low_periods < shortest_reset) {
+                shortest_reset = low_periods;
+            }
+            low_periods = 0;
+            pulse_seen = 1;
+        }
+    }
+    check(shortest_reset >= LED_RESET_CYCLES * 24, "reset of only %.2f us", shortest_reset * SIM_PERIOD_NS / 1000.0);
+
+    check(len < SIM_TRACE_SIZE, "trace full");
+    ws2812_verify_ccr(&verify, ccr, len, LED_CNT, SIM_PERIOD_NS);
+    ws2812_verify_flush(&verify);
+    sim_trace_clear();
+
+    if (ws2812_verify_errors(&verify) > 0) {
+        printf("%lu timing errors, first at %.2f us\n", (unsigned long) ws2812_verify_errors(&verify), verify.first_error / 1000.0);
+    }
+    check(ws2812_verify_errors(&verify) == 0, "timing errors");
+    check(verify.frames > frames, "no frame sent");
+
+}
+
+// Write the compare values sent since last time, each run of zeros (resets and idle) as a single 0, then decode them
+static uint16_t trace_last = 0;
+
+static void print_trace(FILE *out) {
+    uint32_t len;
+    const uint16_t *ccr = sim_trace(&htim4, TIM_CHANNEL_1, &len);
+    for (uint32_t i = 0; i < len; i++) {
+        if (ccr[i] != 0 || trace_last != 0) {
+            fprintf(out, "%u\n", ccr[i]);
+        }
+        trace_last = ccr[i];
+    }
+    decode();
+}
+
+// Frames that only differ in when they are encoded - no changes while sending and no delayed callbacks
+static int trace(const char *file) {
+
+    FILE *out = fopen(file, "w");
+    if (out == NULL) {
+        perror(file);
+        return 1;
+    }
+
+    ws2812_verify_init(&verify, &ws2812_verify_ws2812b, frame, sizeof(frame), latched);
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+    for (uint16_t led = 0; led < LEDS; led++) {
+        setLedValues(&ws2812, led, led, 0x80, 255 - led);
+    }
+    run(SEND_PERIODS(24));
+    print_trace(out);
+
+    setLedValues(&ws2812, LEDS - 1, 0xab, 0xcd, 0xef);
+    run(SEND_PERIODS(24));
+    print_trace(out);
+
+    ws2812_set_partial(&ws2812, 1);
+    setLedValues(&ws2812, 3, 0x44, 0x55, 0x66);
+    run(SEND_PERIODS(24));
+    print_trace(out);
+    ws2812_set_partial(&ws2812, 0);
+
+    ws2812_set_brightness(&ws2812, 100);
+    ws2812_set_gamma(&ws2812, gamma_value);
+    run(SEND_PERIODS(24));
+    print_trace(out);
+    ws2812_set_gamma(&ws2812, NULL);
+    ws2812_set_brightness(&ws2812, 255);
+
+    ws2812_set_idle_stop(&ws2812, 1);
+    setLedValues(&ws2812, 2, 0x77, 0x88, 0x99);
+    run(SEND_PERIODS(24) * 4);
+    print_trace(out);
+    ws2812_set_idle_stop(&ws2812, 0);
+
+    uint8_t led4[LEDS * 4];
+    ws2812_set_format(&ws2812, WS2812_GRBW, led4);
+    for (uint16_t led = 0; led < LEDS; led++) {
+        setLedValuesW(&ws2812, led, led, 1, 2, 255 - led);
+    }
+    run(SEND_PERIODS(32));
+    print_trace(out);
+    ws2812_set_format(&ws2812, WS2812_GRB, ws2812_led);
+
+    ws2812_init_palette(&ws2812, &htim4, TIM_CHANNEL_1, LEDS, palette_index, 4, palette);
+    for (uint16_t led = 0; led < LEDS; led++) {
+        setLedIndex(&ws2812, led, led % 16);
+    }
+    for (uint8_t entry = 0; entry < 16; entry++) {
+        ws2812_set_palette_color(&ws2812, entry, entry * 16, 255 - entry * 16, 0x40);
+    }
+    run(SEND_PERIODS(24));
+    print_trace(out);
+
+    fclose(out);
+    return failures > 0;
+
+}
+
+// Change a led right when the DMA stops - restarts it from the callback
+static uint8_t idle_change = 0;
+
+void ws2812_idle_callback(ws2812_handleTypeDef *ws2812) {
+    if (idle_change) {
+        idle_change = 0;
+        setLedValues(ws2812, 5, 0x55, 0x66, 0x77);
+    }
+}
+
+// Decode a logic analyzer capture - a csv file of time (s) and level per line
+static int decode_csv(const char *file) {
+
+    FILE *csv = fopen(file, "r");
+    if (csv == NULL) {
+        perror(file);
+        return 1;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), csv) != NULL) {
+        ws2812_verify_csv(&verify, line);
+    }
+    ws2812_verify_flush(&verify);
+    fclose(csv);
+
+    printf("%lu frames, %lu bad pulses, %lu bad lows", (unsigned long) verify.frames, (unsigned long) verify.bad_high, (unsigned long) verify.bad_low);
+    if (ws2812_verify_errors(&verify) > 0) {
+        printf(", first at %.2f us", verify.first_error / 1000.0);
+    }
+    printf("\n");
+
+    return ws2812_verify_errors(&verify) > 0;
+
+}
+
+// Frames in the two streaming protocols - led n gets n, value, 255 - n
+static uint32_t adalight_frame(uint8_t *data, uint16_t leds, uint8_t value) {
+    uint32_t len = 0;
+    data[len++] = 'A';
+    data[len++] = 'd';
+    data[len++] = 'a';
+    data[len++] = (leds - 1) >> 8;
+    data[len++] = (leds - 1) & 0xff;
+    data[len++] = data[3] ^ data[4] ^ 0x55;
+    for (uint16_t led = 0; led < leds; led++) {
+        data[len++] = led;
+        data[len++] = value;
+        data[len++] = 255 - led;
+    }
+    return len;
+}
+
+static uint32_t tpm2_frame(uint8_t *data, uint16_t leds, uint8_t value) {
+    uint32_t len = 0;
+    data[len++] = WS2812_STREAM_TPM2_START;
+    data[len++] = WS2812_STREAM_TPM2_DATA;
+    data[len++] = (leds * 3) >> 8;
+    data[len++] = (leds * 3) & 0xff;
+    for (uint16_t led = 0; led < leds; led++) {
+        data[len++] = led;
+        data[len++] = value;
+        data[len++] = 255 - led;
+    }
+    data[len++] = WS2812_STREAM_TPM2_END;
+    return len;
+}
+
+// Frame f of a test animation for the compressed frames
+static void animation(uint8_t *rgb, uint8_t type, uint32_t f, const uint8_t *palette) {
+    for (uint16_t led = 0; led < LEDS; led++) {
+        uint8_t *p = &rgb[led * 3];
+        switch (type) {
+        case 0: // Line of 8 leds moving along a dark string
+            p[0] = p[1] = p[2] = 0;
+            if ((uint16_t) (led - f % LEDS) < 8) {
+                p[0] = f / LEDS * 40;
+                p[1] = 0x80;
+                p[2] = 0x20;
+            }
+            break;
+        case 1: // Rainbow moving - every led changes
+            p[0] = led * 4 + f * 3;
+            p[1] = led * 4 + f * 3 + 85;
+            p[2] = led * 4 + f * 3 + 170;
+            break;
+        default: // Colors cycling through a palette of 16
+            memcpy(p, &palette[(led / 4 + f) % 16 * 3], 3);
+        }
+    }
+}
+
+// Send an animation as delta frames through the UART and check the led values after each.  Periods
+// are sent (and decoded) after each frame, or after the first half of it when split - the frame
+// before is then still waiting to be sent when the next starts.  No periods for frames back to back.
+static void round_trip(const char *name, uint8_t type, uint32_t frames, uint32_t periods, uint8_t split) {
+
+    static uint8_t rgb[LEDS * 3], prev[LEDS * 3], out[STREAM_ENCODE_MAX(LEDS) + 16 * 3];
+    uint8_t palette[16 * 3];
+    uint16_t entries = type == 2 ? 16 : 0;
+    uint64_t bytes = 0;
+    uint32_t bad = 0;
+
+    for (uint8_t i = 0; i < sizeof(palette); i++) {
+        palette[i] = i * 37 + (i >> 2) * 101;
+    }
+
+    if (entries > 0) {
+        uint32_t len = stream_encode_palette(out, palette, 0, entries);
+        sim_uart_receive(&huart1, out, len);
+        bytes += len;
+    }
+
+    for (uint32_t f = 0; f < frames; f++) {
+        animation(rgb, type, f, palette);
+        uint32_t len = stream_encode_delta(out, rgb, f > 0 ? prev : NULL, LEDS, palette, entries);
+        uint32_t first = split ? len / 2 : len;
+        sim_uart_receive(&huart1, out, first);
+        if (periods > 0) {
+            run(periods);
+            if (!split || f > 0) { // Nothing is waiting before the first
+                decode();
+            }
+        }
+        sim_uart_receive(&huart1, &out[first], len - first);
+        bytes += len;
+        const uint8_t *values = ws2812.latched == ws2812.commits ? ws2812.front : ws2812.led; // The last frame committed
+        for (uint16_t led = 0; led < LEDS; led++) {
+            const uint8_t *p = &values[led * ws2812.bpp];
+            bad += p[ws2812.offset[RL]] != rgb[led * 3] || p[ws2812.offset[GL]] != rgb[led * 3 + 1] || p[ws2812.offset[BL]] != rgb[led * 3 + 2];
+        }
+        memcpy(prev, rgb, sizeof(rgb));
+    }
+
+    printf("%-8s %lu frames, %.1f bytes/frame - %.1fx less than Adalight, %lu leds wrong\n", name, (unsigned long) frames, (double) bytes / frames,
+            (double) frames * (6 + LEDS * 3) / bytes, (unsigned long) bad);
+    check(bad == 0, "%s round trip has %lu leds wrong", name, (unsigned long) bad);
+
+}
+
+// Feed a captured byte stream through the UART in bursts of up to 256 bytes
+static int decode_stream(const char *file) {
+
+    FILE *in = fopen(file, "rb");
+    if (in == NULL) {
+        perror(file);
+        return 1;
+    }
+
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+    ws2812_stream_init(&stream, &ws2812, &huart1);
+
+    uint8_t data[256];
+    uint32_t burst = 1;
+    size_t len;
+    while ((len = fread(data, 1, burst, in)) > 0) {
+        sim_uart_receive(&huart1, data, len);
+        run(len * 9); // 10 bits at 921600 baud
+        burst = burst * 75 % 257; // Bursts of every size from 1 to 256
+    }
+    fclose(in);
+
+    run(SEND_PERIODS(24));
+    decode();
+    printf("%lu frames, %lu errors\n", (unsigned long) stream.frames, (unsigned long) stream.errors);
+
+    return stream.errors > 0 || failures > 0;
+
+}
+
+// Pseudo random bytes - the same every run
+static uint32_t random_state = 2463534242U;
+
+static uint8_t random_byte(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state >> 24;
+}
+
+// Transpose one bit at a time - what ws2812_transpose has to come up with
+static void transpose_bits(const uint8_t *const led[], uint8_t strands, uint32_t offset, uint16_t *out) {
+    for (uint8_t c = 0; c < 3; c++) {
+        for (uint8_t b = 0; b < 8; b++) {
+            uint16_t word = 0;
+            for (uint8_t n = 0; n < strands; n++) {
+                word |= ((led[n][offset + c] >> (7 - b)) & 1) << n;
+            }
+            *out++ = word;
+        }
+    }
+}
+
+// Compare the transposes with the bit by bit one on random leds for 1 to 16 strings
+static void transpose_check(uint32_t rounds) {
+
+    static uint8_t leds[16][3];
+    const uint8_t *led[16];
+    uint16_t out[24], expected[24];
+    uint32_t wrong = 0;
+
+    for (uint8_t n = 0; n < 16; n++) {
+        led[n] = leds[n];
+    }
+
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (uint8_t n = 0; n < 16; n++) {
+            leds[n][0] = random_byte();
+            leds[n][1] = random_byte();
+            leds[n][2] = random_byte();
+        }
+        uint8_t strands = round % 16 + 1;
+        ws2812_transpose(led, strands, 0, out);
+        transpose_bits(led, strands, 0, expected);
+        wrong += memcmp(out, expected, sizeof(out)) != 0;
+
+        uint8_t in[16], out8[8];
+        for (uint8_t n = 0; n < 16; n++) {
+            in[n] = leds[n][0];
+        }
+        ws2812_transpose8x8(in, out8);
+        ws2812_transpose16x8(in, out);
+        transpose_bits(led, 16, 0, expected);
+        for (uint8_t b = 0; b < 8; b++) {
+            wrong += out8[b] != (expected[b] & 0xff) || out[b] != expected[b];
+        }
+    }
+
+    printf("%lu random transposes, %lu wrong\n", (unsigned long) rounds, (unsigned long) wrong);
+    check(wrong == 0, "%lu transposes differ from the bit by bit one", (unsigned long) wrong);
+
+}
+
+// Nanoseconds per led spent in ws2812_update_buffer while sending data
+static double benchmark(uint32_t frames) {
+
+    struct timespec start, end;
+    uint64_t ns = 0;
+    uint8_t half = 0;
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        if (ws2812.index != NULL) {
+            setLedIndex(&ws2812, frame % LEDS, frame % WS2812_PALETTE_ENTRIES(ws2812.index_bits));
+        } else {
+            setLedValues(&ws2812, frame % LEDS, frame, frame >> 8, frame >> 16);
+        }
+        ws2812_stateTypeDef state;
+        do { // Until the frame is sent and the reset starts
+            state = ws2812.led_state;
+            htim4.hdma[TIM_DMA_ID_CC1]->Instance->NDTR = (1 + half) * ws2812.buffer_size; // Right on time
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ws2812_update_buffer(&ws2812, &ws2812.dma_buffer[half * ws2812.buffer_size]);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            if (state == LED_DAT) {
+                ns += (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+            }
+            half ^= 1;
+        } while (state != LED_DAT || ws2812.led_state != LED_RES);
+    }
+
+    return (double) ns / frames / LEDS;
+
+}
+
+// Million leds per second decoded from compare values
+static double benchmark_verify(uint32_t frames) {
+
+    static uint16_t ccr[LEDS * 24 + 50];
+    struct timespec start, end;
+
+    for (uint32_t bit = 0; bit < LEDS * 24; bit++) {
+        ccr[bit] = bit * 2654435761U & 0x80000000 ? LED_ON : LED_OFF;
+    }
+    memset(&ccr[LEDS * 24], 0, 50 * sizeof(uint16_t)); // Reset
+
+    ws2812_verify_init(&verify, &ws2812_verify_ws2812b, frame, sizeof(frame), NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < frames; i++) {
+        ws2812_verify_ccr(&verify, ccr, sizeof(ccr) / sizeof(ccr[0]), LED_CNT, SIM_PERIOD_NS);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + end.tv_nsec - start.tv_nsec;
+    return verify.frames * 1e3 * LEDS / ns;
+
+}
+
+// Nanoseconds per byte spent parsing Adalight frames
+static double benchmark_stream(uint32_t frames) {
+
+    struct timespec start, end;
+    uint32_t len = adalight_frame(stream_data, LEDS, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < frames; i++) {
+        ws2812_stream_parse(&stream, stream_data, len);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + end.tv_nsec - start.tv_nsec;
+    return ns / frames / len;
+
+}
+
+// Nanoseconds per led transposing 16 strings of LEDS leds - one led of one string
+static double benchmark_transpose(uint32_t frames) {
+
+    static uint8_t leds[16][LEDS * 3];
+    const uint8_t *led[16];
+    static uint16_t out[24];
+    struct timespec start, end;
+
+    for (uint8_t n = 0; n < 16; n++) {
+        for (uint16_t i = 0; i < LEDS * 3; i++) {
+            leds[n][i] = random_byte();
+        }
+        led[n] = leds[n];
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t f = 0; f < frames; f++) {
+        for (uint16_t i = 0; i < LEDS; i++) {
+            ws2812_transpose(led, 16, i * 3, out);
+            __asm__ volatile("" : : "r" (out) : "memory"); // Keep the result
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + end.tv_nsec - start.tv_nsec;
+    return ns / frames / LEDS / 16;
+
+}
+
+int main(int argc, char *argv[]) {
+
+    if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+        ws2812_verify_init(&verify, &ws2812_verify_ws2812b, frame, sizeof(frame), latched);
+        return decode_stream(argv[2]);
+    }
+
+    if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+        return trace(argv[2]);
+    }
+
+    if (argc > 1) {
+        ws2812_verify_init(&verify, &ws2812_verify_ws2812b, frame, sizeof(frame), NULL);
+        return decode_csv(argv[1]);
+    }
+
+    ws2812_verify_init(&verify, &ws2812_verify_ws2812b, frame, sizeof(frame), latched);
+
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+
+    printf("Idle string\n");
+    run(400);
+
+    printf("Setting %u leds\n", LEDS);
+    for (uint16_t led = 0; led < LEDS; led++) {
+        setLedValues(&ws2812, led, led, 0x80, 255 - led);
+    }
+    run(SEND_PERIODS(24));
+    decode();
+
+    printf("Changing one led while sending\n");
+    setLedValues(&ws2812, 0, 0x12, 0x34, 0x56);
+    run(LEDS * 12);
+    setLedValues(&ws2812, LEDS - 1, 0xab, 0xcd, 0xef);
+    run(SEND_PERIODS(24) * 2);
+    decode();
+
+    printf("Callback held back by %u bits while sending\n", 3 * ws2812.buffer_size / 2);
+    setLedValues(&ws2812, 1, 0x11, 0x22, 0x33);
+    run(ws2812.buffer_size * (LED_RESET_HALVES + 2) + LEDS * 12);
+    sim_delay(3 * ws2812.buffer_size / 2);
+    run(SEND_PERIODS(24) * 2);
+    decode();
+    printf("%lu underruns\n", (unsigned long) ws2812.underruns);
+    check(ws2812.underruns == 1, "%lu underruns instead of 1", (unsigned long) ws2812.underruns);
+
+    printf("Partial refresh\n");
+    ws2812_set_partial(&ws2812, 1);
+    run(SEND_PERIODS(24));
+    decode();
+    setLedValues(&ws2812, 3, 0x44, 0x55, 0x66);
+    run(SEND_PERIODS(24));
+    decode();
+    check(frame_bits == 4 * 24, "partial frame of %lu bits instead of 4 leds", (unsigned long) frame_bits);
+    ws2812_set_partial(&ws2812, 0);
+
+    printf("Idle stop\n");
+    ws2812_set_idle_stop(&ws2812, 1);
+    run(SEND_PERIODS(24));
+    decode();
+    uint32_t dma_cbs = ws2812.dma_cbs;
+    run(10000);
+    printf("%lu callbacks in %.1f ms idle\n", (unsigned long) (ws2812.dma_cbs - dma_cbs), 10000 * SIM_PERIOD_NS / 1e6);
+    check(ws2812.dma_cbs == dma_cbs && ws2812_power_state(&ws2812) == WS2812_POWER_IDLE, "callbacks while idle");
+    setLedValues(&ws2812, 2, 0x77, 0x88, 0x99);
+    run(SEND_PERIODS(24));
+    decode();
+    printf("Change when stopping\n");
+    idle_change = 1;
+    setLedValues(&ws2812, 4, 0x44, 0x55, 0x66);
+    run(SEND_PERIODS(24) * 2);
+    decode();
+    check(idle_change == 0 && ws2812_power_state(&ws2812) == WS2812_POWER_IDLE, "no change when stopping");
+    printf("shortest reset %.2f us\n", shortest_reset * SIM_PERIOD_NS / 1000.0);
+
+    printf("Led power off after 5 ms dark\n");
+    ws2812_set_power_pin(&ws2812, &led_power, 0x0001, GPIO_PIN_SET, 5);
+    zeroLedValues(&ws2812);
+    run(SEND_PERIODS(24));
+    decode();
+    printf("next activity in %lu ms\n", (unsigned long) ws2812_next_activity_all());
+    for (uint8_t i = 0; i < 10 && ws2812_power_state_all() != WS2812_POWER_OFF; i++) { // 8 ms at most
+        run(800);
+        ws2812_power_tick(&ws2812);
+    }
+    printf("%10.2f us  power off, next activity %s\n", sim_time() / 1000.0, ws2812_next_activity_all() == WS2812_NEVER ? "never" : "pending");
+    check(ws2812_power_state_all() == WS2812_POWER_OFF && (led_power.ODR & 0x0001) == 0, "led power still on");
+    setLedValues(&ws2812, 0, 0x01, 0x02, 0x03);
+    printf("%10.2f us  power %s\n", sim_time() / 1000.0, led_power.ODR & 0x0001 ? "on" : "off");
+    check(led_power.ODR & 0x0001, "led power still off");
+    run(SEND_PERIODS(24) + WS2812_POWER_ON_HALVES * WS2812_MAX_BUFFER_SIZE);
+    decode();
+    ws2812_set_power_pin(&ws2812, NULL, 0, GPIO_PIN_SET, 0);
+    ws2812_set_idle_stop(&ws2812, 0);
+
+    run(SEND_PERIODS(24));
+    decode();
+
+    printf("Adalight and TPM2 over UART\n");
+    ws2812_stream_init(&stream, &ws2812, &huart1);
+    uint32_t len = adalight_frame(stream_data, LEDS, 0x42);
+    sim_uart_receive(&huart1, stream_data, len / 2);
+    run(len / 2 * 9);
+    sim_uart_receive(&huart1, &stream_data[len / 2], len - len / 2);
+    run(SEND_PERIODS(24));
+    decode();
+    sim_uart_receive(&huart1, (const uint8_t*) "xAdx", 4); // Noise and a broken header
+    len = tpm2_frame(stream_data, LEDS, 0x24);
+    sim_uart_receive(&huart1, stream_data, len);
+    run(SEND_PERIODS(24));
+    decode();
+    printf("%lu frames, %lu errors\n", (unsigned long) stream.frames, (unsigned long) stream.errors);
+    check(stream.frames == 2 && stream.errors == 1, "stream frames or errors");
+
+    printf("Compressed frames\n");
+    round_trip("line", 0, 1000, 0, 0);
+    round_trip("rainbow", 1, 1000, 0, 0);
+    round_trip("palette", 2, 1000, 0, 0);
+    run(SEND_PERIODS(24));
+    decode();
+    printf("%lu frames, %lu errors\n", (unsigned long) stream.frames, (unsigned long) stream.errors);
+    check(stream.frames == 3002 && stream.errors == 1, "stream frames or errors");
+
+    printf("RGBW\n");
+    uint8_t led4[LEDS * 4];
+    ws2812_set_format(&ws2812, WS2812_GRBW, led4);
+    setLedValuesW(&ws2812, 0, 1, 2, 3, 4);
+    run(SEND_PERIODS(32));
+    decode();
+    ws2812_set_idle_stop(&ws2812, 1); // The white byte has to be in before the DMA restarts
+    run(SEND_PERIODS(32));
+    check(ws2812_power_state(&ws2812) == WS2812_POWER_IDLE, "RGBW string not stopped");
+    setLedValuesW(&ws2812, 0, 0x11, 0x22, 0x33, 0x44);
+    run(SEND_PERIODS(32));
+    decode();
+    check(frame[0] == 0x22 && frame[1] == 0x11 && frame[2] == 0x33 && frame[3] == 0x44, "restarted with white %02x", frame[3]);
+    ws2812_set_idle_stop(&ws2812, 0);
+    ws2812_set_format(&ws2812, WS2812_GRB, ws2812_led);
+    check(ws2812.underruns == 1, "%lu underruns instead of 1", (unsigned long) ws2812.underruns);
+
+    printf("Double buffer\n");
+    uint8_t front[LEDS * 3];
+    ws2812_set_double_buffer(&ws2812, front);
+    round_trip("buffered", 0, 30, SEND_PERIODS(24), 0); // Streamed deltas build on the frame shown
+    round_trip("queued", 1, 30, SEND_PERIODS(24), 1);
+    run(SEND_PERIODS(24));
+    decode();
+    for (uint8_t f = 1; f <= 3; f++) {
+        uint8_t *back = ws2812.led;
+        for (uint16_t led = 0; led < LEDS; led++) {
+            setLedValues(&ws2812, led, f, led, 0x10);
+        }
+        ws2812_commit(&ws2812);
+        run(SEND_PERIODS(24) * 2);
+        decode();
+        check(ws2812_is_displayed(&ws2812) && ws2812.front == back && ws2812.led != back, "commit %u not swapped in", f);
+    }
+    ws2812_set_double_buffer(&ws2812, NULL);
+    check(ws2812.led == ws2812.front && ws2812.led[1] == 3, "single buffer without the last commit");
+
+    printf("Gamma and brightness\n");
+    for (uint16_t led = 0; led < LEDS; led++) {
+        setLedValues(&ws2812, led, led * 4, 255 - led * 4, led * 4 + 2);
+    }
+    ws2812_set_gamma(&ws2812, gamma_value);
+    run(SEND_PERIODS(24));
+    const uint16_t *ccr = sim_trace(&htim4, TIM_CHANNEL_1, &len);
+    uint32_t first = 0;
+    while (first < len && ccr[first] == 0) {
+        first++;
+    }
+    uint16_t wrong = 0;
+    const uint8_t led1[3] = { gamma_value[251], gamma_value[4], gamma_value[6] };
+    for (uint8_t bit = 0; bit < 24 && first + 48 <= len; bit++) { // Led 1 is sent as the color_value patterns of its corrected values
+        wrong += ccr[first + 24 + bit] != color_value[led1[bit / 8]][bit % 8];
+    }
+    check(first + 48 <= len && wrong == 0, "led 1 not sent as color_value[gamma_value[x]]");
+    decode();
+    wrong = 0;
+    for (uint16_t led = 0; led < LEDS; led++) { // Wire order is green, red, blue
+        wrong += frame[led * 3] != gamma_value[255 - led * 4] || frame[led * 3 + 1] != gamma_value[led * 4] || frame[led * 3 + 2] != gamma_value[led * 4 + 2];
+    }
+    check(wrong == 0 && frame[1] == 0 && frame[0] == 255, "%u leds not gamma corrected", wrong);
+    ws2812_set_brightness(&ws2812, 0);
+    run(SEND_PERIODS(24));
+    decode();
+    wrong = 0;
+    for (uint16_t i = 0; i < LEDS * 3; i++) {
+        wrong += frame[i] != 0;
+    }
+    check(wrong == 0 && frame_bits == LEDS * 24, "brightness 0 frame not all zeros");
+    ws2812_set_gamma(&ws2812, NULL);
+    ws2812_set_brightness(&ws2812, 255);
+    run(SEND_PERIODS(24));
+    decode();
+
+    printf("Dithering\n");
+    ws2812_set_format(&ws2812, WS2812_GRBW, led4);
+    ws2812_set_dither(&ws2812, value16, error);
+    uint16_t value16_set[LEDS * 4];
+    for (uint16_t led = 0; led < LEDS; led++) { // Fractions all over in wire order - the top 0xff00 and up is clipped
+        uint16_t *v = &value16_set[led * 4];
+        v[0] = led * 257 + 0x80;
+        v[1] = led * 1021 % 0xff00;
+        v[2] = 0xfe00 - led * 255;
+        v[3] = led * 31 + 0x11;
+        setLedValues16W(&ws2812, led, v[1], v[0], v[2], v[3]);
+    }
+    run_to_reset(SEND_PERIODS(32) * 2); // Frames encoded before the values were set
+    decode();
+    memset(dither_sum, 0, sizeof(dither_sum));
+    dither_frames = 0;
+    while (dither_frames < 64) {
+        run_to_reset(SEND_PERIODS(32) / 2);
+        decode();
+    }
+    wrong = 0;
+    for (uint16_t i = 0; i < LEDS * 4; i++) { // Within 1/frames of value16 / 256 - the error carried is less than 1
+        int64_t diff = (int64_t) dither_sum[i] * 256 - (int64_t) dither_frames * value16_set[i];
+        wrong += diff <= -256 || diff >= 256;
+    }
+    check(wrong == 0, "%u led values averaged over %lu frames off", wrong, (unsigned long) dither_frames);
+    ws2812_set_dither(&ws2812, NULL, NULL); // Possibly after a dithered frame has started
+    run(SEND_PERIODS(32) * 2);
+    decode();
+    ws2812_set_format(&ws2812, WS2812_GRB, ws2812_led);
+
+    printf("Frame buffer\n");
+    ws2812_set_frame_buffer(&ws2812, frame_buffer, sizeof(frame_buffer) / sizeof(frame_buffer[0]));
+    uint32_t enc_frames = ws2812.enc_frames;
+    uint32_t frames = verify.frames;
+    run_to_reset(SEND_PERIODS(24) * 3); // Sent over and over - as encoded once
+    decode();
+    check(verify.frames - frames >= 3 && ws2812.enc_frames == enc_frames, "%lu frames encoded for %lu sent", (unsigned long) (ws2812.enc_frames - enc_frames), (unsigned long) (verify.frames - frames));
+    setLedValues(&ws2812, 5, 0x12, 0x34, 0x56);
+    run_to_reset(SEND_PERIODS(24) * 3); // The change goes into the next pass
+    decode();
+    check(ws2812.enc_frames == enc_frames + 1 && memcmp(&frame[15], "\x34\x12\x56", 3) == 0, "change encoded %lu times", (unsigned long) (ws2812.enc_frames - enc_frames));
+    ws2812_set_idle_stop(&ws2812, 1);
+    ws2812_set_power_pin(&ws2812, &led_power, 0x0001, GPIO_PIN_SET, 5);
+    zeroLedValues(&ws2812);
+    run(SEND_PERIODS(24) * 2);
+    decode();
+    for (uint8_t i = 0; i < 10 && ws2812_power_state(&ws2812) != WS2812_POWER_OFF; i++) {
+        run(800);
+        ws2812_power_tick(&ws2812);
+    }
+    check(ws2812_power_state(&ws2812) == WS2812_POWER_OFF, "frame buffer led power still on");
+    sim_trace_clear();
+    setLedValues(&ws2812, 0, 0x01, 0x02, 0x03);
+    run(WS2812_POWER_ON_HALVES * ws2812.buffer_size + SEND_PERIODS(24) * 2);
+    ccr = sim_trace(&htim4, TIM_CHANNEL_1, &len);
+    first = 0;
+    while (first < len && ccr[first] == 0) {
+        first++;
+    }
+    printf("%.2f us from power on to the first led\n", first * SIM_PERIOD_NS / 1000.0);
+    check(first >= WS2812_POWER_ON_HALVES * ws2812.buffer_size, "leds sent %lu periods after power on", (unsigned long) first);
+    decode();
+    check(frame[0] == 0x02 && frame[1] == 0x01 && frame[2] == 0x03, "frame buffer not sent after power on");
+    ws2812_set_power_pin(&ws2812, NULL, 0, GPIO_PIN_SET, 0);
+    ws2812_set_idle_stop(&ws2812, 0);
+    ws2812_set_frame_buffer(&ws2812, NULL, 0);
+    run(SEND_PERIODS(24));
+    decode();
+
+    printf("Palette with 4 bit indices\n");
+    ws2812_init_palette(&ws2812, &htim4, TIM_CHANNEL_1, LEDS, palette_index, 4, palette);
+    for (uint16_t led = 0; led < LEDS; led++) {
+        setLedIndex(&ws2812, led, led % 16);
+    }
+    for (uint8_t cycle = 0; cycle < 3; cycle++) { // Color cycling - 16 palette entries instead of all leds
+        for (uint8_t entry = 0; entry < 16; entry++) {
+            uint8_t c = (entry + cycle) * 16;
+            ws2812_set_palette_color(&ws2812, entry, c, 255 - c, 0x40);
+        }
+        run(SEND_PERIODS(24));
+        decode();
+    }
+    ws2812_set_format(&ws2812, WS2812_GRBW, palette);
+    ws2812_set_palette_colorW(&ws2812, 1, 1, 2, 3, 4);
+    run(SEND_PERIODS(32));
+    decode();
+    ws2812_set_idle_stop(&ws2812, 1);
+    run(SEND_PERIODS(32));
+    check(ws2812_power_state(&ws2812) == WS2812_POWER_IDLE, "palette string not stopped");
+    ws2812_set_palette_colorW(&ws2812, 1, 0x11, 0x22, 0x33, 0x44);
+    run(SEND_PERIODS(32));
+    decode();
+    check(memcmp(&frame[4], "\x22\x11\x33\x44", 4) == 0, "palette entry restarted with white %02x", frame[7]);
+    ws2812_set_idle_stop(&ws2812, 0);
+    printf("%u leds in %lu bytes instead of %u\n", LEDS, (unsigned long) (sizeof(palette_index) + WS2812_PALETTE_ENTRIES(4) * 3), LEDS * 3);
+    check(ws2812.underruns == 0, "%lu underruns", (unsigned long) ws2812.underruns);
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+
+    printf("Transposing parallel strings\n");
+    transpose_check(100000);
+
+    // Nobody is looking - stop the DMA and call update_buffer directly
+    HAL_TIM_PWM_Stop_DMA(&htim4, TIM_CHANNEL_1);
+
+    printf("ws2812_update_buffer %.1f ns/led\n", benchmark(10000));
+    ws2812_set_brightness(&ws2812, 128);
+    ws2812_set_gamma(&ws2812, gamma_value);
+    printf("ws2812_update_buffer %.1f ns/led with brightness and gamma\n", benchmark(10000));
+    ws2812_set_dither(&ws2812, value16, error);
+    ws2812_streamTypeDef dither_stream;
+    check(ws2812_stream_init(&dither_stream, &ws2812, &huart1) == WS2812_Err, "stream on a dithering handle");
+    printf("ws2812_update_buffer %.1f ns/led dithering\n", benchmark(10000));
+
+    printf("ws2812_verify_ccr %.1f million leds/s\n", benchmark_verify(10000));
+    printf("ws2812_stream_parse %.2f ns/byte\n", benchmark_stream(100000));
+    printf("ws2812_transpose %.2f ns/led with 16 strings\n", benchmark_transpose(10000));
+
+    ws2812_init_palette(&ws2812, &htim4, TIM_CHANNEL_1, LEDS, palette_index, 4, palette);
+    HAL_TIM_PWM_Stop_DMA(&htim4, TIM_CHANNEL_1);
+    printf("ws2812_update_buffer %.1f ns/led palette\n", benchmark(10000));
+
+    if (failures > 0) {
+        printf("%lu checks failed\n", (unsigned long) failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+
+    return 0;
+
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
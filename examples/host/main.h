@@ -0,0 +1,37 @@
+/**
+ ******************************************************************************
+ * @file           : main.h
+ * @brief          : Host simulation main header
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include "hal_sim.h"
+
+// Same timing as the f411 example - 100 MHz timer clock / 125 = 800 kHz
+#ifndef LED_CNT
+#define LED_CNT 125
+#endif
+
+#define LEDS 64
+
+#define WS2812_MAX_BPP 4                    // RGBW is simulated as well
+
+#define WS2812_STREAM
+
+#endif /* __MAIN_H */
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * @file           : rtos_check.c
+ * @brief          : Check the ws2812_rtos frame handoff on the simulated DMA
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * The simulation is a Cortex-M0 to ws2812_rtos, so the exchange takes the
+ * PRIMASK path.  Plays a producer task drawing numbered frames and publishing
+ * them at ever different offsets from the frame starts, now and then with the
+ * DMA callbacks running for a while right where the exchange lets them in
+ * again.  After every period the producer, the DMA and the ready slot must
+ * each hold a different buffer, and every frame the leds latch must be one
+ * published whole and not older than the one before.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+#include "ws2812_verify.h"
+#include "ws2812_rtos.h"
+
+// Simulated periods per FreeRTOS tick
+#define PERIODS_PER_TICK (1000000 / SIM_PERIOD_NS)
+
+// Periods from one frame start to the next when sending back to back
+#define FRAME_PERIODS (LEDS * 24 + LED_RESET_HALVES * WS2812_MAX_BUFFER_SIZE)
+
+// Frames published - all numbers fit the first led byte
+#define FRAMES 250
+
+TIM_HandleTypeDef htim4;
+
+WS2812_DECLARE(ws2812, LEDS);
+WS2812_RTOS_DECLARE(rtos, LEDS);
+
+uint8_t frame[LEDS * 4];
+ws2812_verifyTypeDef verify;
+
+static uint32_t failures = 0;
+
+static void check(int ok, const char *format, ...) {
+    if (!ok) {
+        va_list args;
+        va_start(args, format);
+        fprintf(stderr, "FAIL at %.2f us: ", sim_time() / 1000.0);
+        vfprintf(stderr, format, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+        ++failures;
+    }
+}
+
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
+    ws2812_tim_half_callback(htim);
+}
+
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
+    ws2812_tim_full_callback(htim);
+}
+
+// Byte i of frame n in wire order - the first is the frame number
+static uint8_t pattern(uint32_t n, uint32_t i) {
+    return n + i * 7;
+}
+
+// Newest frame latched by the leds
+static int32_t shown = -1;
+static uint32_t frames_latched = 0;
+
+static void latched(ws2812_verifyTypeDef *verify, uint32_t bits) {
+    uint8_t n = verify->frame[0];
+    uint16_t wrong = 0;
+    for (uint32_t i = 0; i < LEDS * 3; i++) {
+        wrong += verify->frame[i] != pattern(n, i);
+    }
+    check(bits == LEDS * 24 && wrong == 0, "frame %lu torn - %u bytes not from frame %u", (unsigned long) verify->frames, wrong, n);
+    check(n >= shown, "frame %u latched after frame %ld", n, (long) shown);
+    shown = n;
+    ++frames_latched;
+}
+
+// Buffer the producer gets back from the exchange while it is interrupted in ws2812_rtos_publish or -1
+static int8_t publishing = -1;
+
+// No buffer on two sides at once
+static void check_buffers(void) {
+    if (publishing >= 0) { // The producer copies the frame just published into the buffer it got back
+        check(rtos.front != publishing, "DMA sending buffer %d the producer draws next", publishing);
+        return;
+    }
+    uint8_t ready = rtos.ready & WS2812_RTOS_INDEX;
+    check(rtos.back != rtos.front && rtos.back != ready && rtos.front != ready, "buffers %u, %u and %u drawn, sent and ready", rtos.back, rtos.front, ready);
+    check(ws2812.led == rtos.buffer[rtos.back] && ws2812.front == rtos.buffer[rtos.front], "handle not drawing and sending the rtos buffers");
+}
+
+// Run the DMA checking the buffers every period and decode what is sent
+static void step(uint32_t periods) {
+    uint32_t len;
+    while (periods--) {
+        sim_run(1);
+        check_buffers();
+        if (periods % 1024 == 0) {
+            const uint16_t *ccr = sim_trace(&htim4, TIM_CHANNEL_1, &len);
+            ws2812_verify_ccr(&verify, ccr, len, LED_CNT, SIM_PERIOD_NS);
+            sim_trace_clear();
+        }
+    }
+}
+
+// Periods the callbacks run for the next time PRIMASK is cleared - interrupting ws2812_rtos_publish after the exchange
+static uint32_t preempt = 0;
+
+static void unmask(void) {
+    if (preempt > 0 && publishing >= 0) {
+        uint32_t periods = preempt;
+        preempt = 0;
+        step(periods);
+    }
+}
+
+// The producer task as far as ws2812_rtos is concerned - time only passes while it waits
+static uint8_t task;
+static uint32_t notified = 0;
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return &task;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return HAL_GetTick();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    step(ticks * PERIODS_PER_TICK);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t waiting, BaseType_t *woken) {
+    check(waiting == &task && rtos.waiting == &task, "notified while not waiting");
+    check(ws2812_is_displayed(&ws2812), "notified before the last frame published was displayed");
+    ++notified;
+    *woken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t timeout) {
+    uint32_t periods = timeout * PERIODS_PER_TICK;
+    while (notified == 0 && periods > 0) {
+        step(1);
+        periods--;
+    }
+    uint32_t count = notified;
+    if (clear) {
+        notified = 0;
+    } else if (count > 0) {
+        notified--;
+    }
+    return count;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout) {
+    (void) queue;
+    (void) item;
+    (void) timeout;
+    return pdTRUE;
+}
+
+// Draw frame n into the back buffer - the second half of the leds after running the DMA for a while
+static void draw(uint32_t n, uint32_t periods) {
+    for (uint16_t led = 0; led < LEDS; led++) { // Wire order is green, red, blue
+        if (led == LEDS / 2) {
+            step(periods);
+        }
+        setLedValues(&ws2812, led, pattern(n, led * 3 + 1), pattern(n, led * 3), pattern(n, led * 3 + 2));
+    }
+}
+
+int main(void) {
+
+    ws2812_verify_init(&verify, &ws2812_verify_ws2812b, frame, sizeof(frame), latched);
+
+    WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+    draw(0, 0);
+    check(WS2812_RTOS_INIT_STATIC(rtos, &ws2812) == WS2812_Ok, "rtos init");
+    sim_unmask = unmask;
+    step(FRAME_PERIODS * 2);
+
+    for (uint32_t n = 1; n < FRAMES; n++) {
+
+        uint32_t offset = n * 97 % FRAME_PERIODS; // Publish anywhere from a frame start
+        draw(n, offset / 2);
+
+        preempt = n % 3 == 0 ? 0 : n * 61 % FRAME_PERIODS + 1;
+        publishing = rtos.ready & WS2812_RTOS_INDEX;
+        ws2812_rtos_publish(&rtos);
+        publishing = -1;
+        preempt = 0;
+        check_buffers();
+
+        if (n % 8 == 0) { // Frames before have been skipped or shown
+            check(ws2812_rtos_wait_displayed(&rtos, 10) == WS2812_Ok, "frame %lu not displayed", (unsigned long) n);
+            step(LED_RESET_CYCLES * 24); // Until the leds have latched it
+            check(shown == (int32_t) n, "frame %lu displayed while frame %ld shown", (unsigned long) n, (long) shown);
+        } else {
+            step(offset - offset / 2);
+        }
+
+    }
+
+    step(FRAME_PERIODS * 2);
+    ws2812_verify_flush(&verify);
+
+    printf("%lu frames published, %lu latched, %lu skipped\n", (unsigned long) FRAMES, (unsigned long) frames_latched, (unsigned long) rtos.skipped);
+    check(shown == FRAMES - 1, "last frame latched %ld", (long) shown);
+    check(rtos.skipped > 0 && frames_latched > FRAMES / 4, "no frames skipped or too few latched");
+    check(ws2812_verify_errors(&verify) == 0, "%lu timing errors", (unsigned long) ws2812_verify_errors(&verify));
+
+    if (failures > 0) {
+        printf("%lu checks failed\n", (unsigned long) failures);
+        return 1;
+    }
+    printf("All checks passed\n");
+
+    return 0;
+
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,111 @@
+/**
+ ******************************************************************************
+ * @file           : stream_encode.c
+ * @brief          : Encoder for the compressed frames of ws2812_stream
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "main.h"
+
+#include "ws2812_stream.h"
+#include "stream_encode.h"
+
+// TPM2 header and end around a payload of len bytes from out[4] on
+static uint32_t stream_encode_packet(uint8_t *out, uint8_t type, uint32_t len) {
+    out[0] = WS2812_STREAM_TPM2_START;
+    out[1] = type;
+    out[2] = len >> 8;
+    out[3] = len & 0xff;
+    out[4 + len] = WS2812_STREAM_TPM2_END;
+    return len + 5;
+}
+
+uint32_t stream_encode_palette(uint8_t *out, const uint8_t *palette, uint8_t first, uint16_t entries) {
+    out[4] = first;
+    memcpy(&out[5], palette, entries * 3);
+    return stream_encode_packet(out, WS2812_STREAM_TPM2_PALETTE, 1 + entries * 3);
+}
+
+static int stream_encode_index(const uint8_t *color, const uint8_t *palette, uint16_t entries) {
+    for (uint16_t i = 0; i < entries; i++) {
+        if (memcmp(color, &palette[i * 3], 3) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t stream_encode_delta(uint8_t *out, const uint8_t *rgb, const uint8_t *prev, uint16_t leds, const uint8_t *palette, uint16_t entries) {
+
+    uint8_t *op = &out[4];
+    uint32_t len = 0;
+    uint32_t used = 0; // Payload up to the last op which isn't a skip
+
+#define CHANGED(l) (prev == NULL || memcmp(&rgb[(l) * 3], &prev[(l) * 3], 3) != 0)
+#define SAME(a, b) (memcmp(&rgb[(a) * 3], &rgb[(b) * 3], 3) == 0)
+#define RUN(l) ((l) + 1 < leds && SAME(l, (l) + 1))
+#define INDEX(l) stream_encode_index(&rgb[(l) * 3], palette, entries)
+
+    uint16_t led = 0;
+    while (led < leds) {
+
+        uint16_t n = 1;
+
+        if (!CHANGED(led)) {
+            while (led + n < leds && n < WS2812_STREAM_OP_MAX && !CHANGED(led + n)) {
+                n++;
+            }
+            op[len++] = WS2812_STREAM_OP_SKIP | (n - 1);
+            led += n;
+            continue;
+        }
+
+        if (RUN(led)) {
+            while (led + n < leds && n < WS2812_STREAM_OP_MAX && SAME(led, led + n)) {
+                n++;
+            }
+            op[len++] = WS2812_STREAM_OP_RUN | (n - 1);
+            memcpy(&op[len], &rgb[led * 3], 3);
+            len += 3;
+        } else if (INDEX(led) >= 0) { // Changed leds up to the next run or color not in the palette
+            while (led + n < leds && n < WS2812_STREAM_OP_MAX && CHANGED(led + n) && !RUN(led + n) && INDEX(led + n) >= 0) {
+                n++;
+            }
+            op[len++] = WS2812_STREAM_OP_INDEX | (n - 1);
+            for (uint16_t i = 0; i < n; i++) {
+                op[len++] = INDEX(led + i);
+            }
+        } else {
+            while (led + n < leds && n < WS2812_STREAM_OP_MAX && CHANGED(led + n) && !RUN(led + n) && INDEX(led + n) < 0) {
+                n++;
+            }
+            op[len++] = WS2812_STREAM_OP_LITERAL | (n - 1);
+            memcpy(&op[len], &rgb[led * 3], n * 3);
+            len += n * 3;
+        }
+
+        led += n;
+        used = len;
+
+    }
+
+    // Leds after the last op keep their values anyway
+    return stream_encode_packet(out, WS2812_STREAM_TPM2_DELTA, used);
+
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
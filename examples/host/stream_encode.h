@@ -0,0 +1,42 @@
+/**
+ ******************************************************************************
+ * @file           : stream_encode.h
+ * @brief          : Encoder for the compressed frames of ws2812_stream
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Host side of the TPM2 palette and delta packets described in
+ * ws2812_stream.h.  Frames are leds * 3 bytes of r, g and b.
+ */
+
+#ifndef STREAM_ENCODE_H_
+#define STREAM_ENCODE_H_
+
+#include <stdint.h>
+
+// Largest packet for a frame of leds
+#define STREAM_ENCODE_MAX(leds) (5 + 4 * (uint32_t) (leds))
+
+// Palette packet of entries colors from index first on - returns its length
+uint32_t stream_encode_palette(uint8_t *out, const uint8_t *palette, uint8_t first, uint16_t entries);
+
+// Delta packet for a frame - prev is the frame before or NULL, colors found
+// in palette (entries long, may be 0) are sent as indices.  Returns its length.
+uint32_t stream_encode_delta(uint8_t *out, const uint8_t *rgb, const uint8_t *prev, uint16_t leds, const uint8_t *palette, uint16_t entries);
+
+#endif /* STREAM_ENCODE_H_ */
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -18,6 +18,23 @@
 #ifndef COLOR_VALUES_H_
 #define COLOR_VALUES_H_
 
-extern const uint16_t color_value[256][8];
+// Generator for the color lookup table.  Expands to the 256 rows of 8 compare
+// values (msb first) for a given pair of "off" and "on" compare values, so a
+// table for any other timing split or DMA width can be declared with:
+//   const uint16_t my_values[256][8] = COLOR_VALUE_TABLE(my_off, my_on);
+#define COLOR_BIT(v, b, off, on) ((((v) >> (b)) & 1) ? (on) : (off))
+#define COLOR_ROW(v, off, on) { \
+        COLOR_BIT(v, 7, off, on), COLOR_BIT(v, 6, off, on), COLOR_BIT(v, 5, off, on), COLOR_BIT(v, 4, off, on), \
+        COLOR_BIT(v, 3, off, on), COLOR_BIT(v, 2, off, on), COLOR_BIT(v, 1, off, on), COLOR_BIT(v, 0, off, on) }
+#define COLOR_ROWS4(v, off, on) \
+        COLOR_ROW((v) + 0, off, on), COLOR_ROW((v) + 1, off, on), COLOR_ROW((v) + 2, off, on), COLOR_ROW((v) + 3, off, on)
+#define COLOR_ROWS16(v, off, on) \
+        COLOR_ROWS4((v) + 0, off, on), COLOR_ROWS4((v) + 4, off, on), COLOR_ROWS4((v) + 8, off, on), COLOR_ROWS4((v) + 12, off, on)
+#define COLOR_ROWS64(v, off, on) \
+        COLOR_ROWS16((v) + 0, off, on), COLOR_ROWS16((v) + 16, off, on), COLOR_ROWS16((v) + 32, off, on), COLOR_ROWS16((v) + 48, off, on)
+#define COLOR_VALUE_TABLE(off, on) { \
+        COLOR_ROWS64(0, off, on), COLOR_ROWS64(64, off, on), COLOR_ROWS64(128, off, on), COLOR_ROWS64(192, off, on) }
+
+extern const ws2812_dmaTypeDef color_value[256][8];
 
 #endif /* COLOR_VALUES_H_ */
@@ -0,0 +1,25 @@
+/**
+ ******************************************************************************
+ * @file           : gamma_values.h
+ * @brief          : Ws2812b library gamma values
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef GAMMA_VALUES_H_
+#define GAMMA_VALUES_H_
+
+extern const uint8_t gamma_value[256];
+
+void gamma_fill(uint8_t *table, float exponent);
+
+#endif /* GAMMA_VALUES_H_ */
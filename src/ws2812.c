@@ -29,39 +29,236 @@
 #include "ws2812.h"
 #include "color_values.h"
 
+// Registry of initialized handles used for dispatching timer callbacks
+static ws2812_handleTypeDef *ws2812_strands[WS2812_MAX_STRANDS];
+static uint8_t ws2812_strand_cnt = 0;
+
+static void ws2812_wake(ws2812_handleTypeDef *ws2812);
+static void ws2812_stop(ws2812_handleTypeDef *ws2812);
+
+// Bytes per led followed by the position of GL, RL, BL and WL for each format
+static const uint8_t ws2812_formats[WS2812_FORMATS][5] = {
+    [WS2812_GRB]  = { 3, 0, 1, 2, 0 },
+    [WS2812_RGB]  = { 3, 1, 0, 2, 0 },
+    [WS2812_BRG]  = { 3, 2, 1, 0, 0 },
+    [WS2812_GRBW] = { 4, 0, 1, 2, 3 },
+    [WS2812_RGBW] = { 4, 1, 0, 2, 3 },
+};
+
 /*
- * Update next 24 bits in the dma buffer - assume dma_buffer_pointer is pointing
- * to the buffer that is safe to update.  The dma_buffer_pointer and the call to
- * this function is handled by the dma callbacks.
+ * Make a committed back buffer the front buffer.  Only called between two
+ * frames so every frame sent is one consistent commit.  The two buffers trade
+ * places - the new back buffer holds the frame before.
  */
-inline void ws2812_update_buffer(ws2812_handleTypeDef *ws2812, uint16_t *dma_buffer_pointer) {
+static inline void ws2812_latch(ws2812_handleTypeDef *ws2812) {
+    uint32_t commits = ws2812->commits;
+    if (ws2812->latched != commits) {
+        if (ws2812->latch_hook != NULL) {
+            ws2812->latch_hook(ws2812);
+        } else if (ws2812->front != ws2812->led) { // Single buffered - nothing to swap
+            uint8_t *front = ws2812->front;
+            ws2812->front = ws2812->led;
+            ws2812->led = front;
+        }
+        ws2812->latched = commits;
+    }
+}
 
-#ifdef BUFF_GPIO_Port
-	HAL_GPIO_WritePin(BUFF_GPIO_Port, BUFF_Pin, GPIO_PIN_SET);
+// The leds have latched the last frame sent
+static inline void ws2812_displayed(ws2812_handleTypeDef *ws2812) {
+    if (ws2812->displayed != ws2812->latched) {
+        ws2812->displayed = ws2812->latched;
+        if (ws2812->displayed_hook != NULL) {
+            ws2812->displayed_hook(ws2812);
+        }
+    }
+}
+
+// Palette entry of a led in palette mode
+static inline uint8_t ws2812_palette_entry(ws2812_handleTypeDef *ws2812, uint32_t led) {
+    if (ws2812->index_bits == 8) {
+        return ws2812->index[led];
+    }
+    return (ws2812->index[led >> 1] >> ((led & 1) << 2)) & 0x0f;
+}
+
+/*
+ * Palette mode - encode the palette colors of the leds covered by offset and
+ * bytes, which count led values as if there were any.  Brightness and gamma
+ * still go through the lookup table.
+ */
+static inline ws2812_dmaTypeDef* ws2812_encode_palette(ws2812_handleTypeDef *ws2812, uint32_t offset, uint32_t bytes, ws2812_dmaTypeDef *dma_buffer_pointer) {
+
+    uint8_t bpp = ws2812->bpp;
+    const uint8_t *lut = ws2812->use_lut ? ws2812->lut : NULL;
+
+    for (uint32_t led = offset / bpp; led < (offset + bytes) / bpp; led++) {
+        const uint8_t *color = &ws2812->palette[ws2812_palette_entry(ws2812, led) * bpp];
+        for (uint8_t i = 0; i < bpp; i++) {
+            memcpy(dma_buffer_pointer, color_value[lut != NULL ? lut[color[i]] : color[i]], sizeof(color_value[0]));
+            dma_buffer_pointer += 8; // next 8 bits
+        }
+    }
+
+    return dma_buffer_pointer;
+
+}
+
+/*
+ * Encode a number of led bytes starting at offset into the dma buffer returning
+ * the position following them.  Led values are stored in wire order so color
+ * order and RGB or RGBW leds make no difference here - just the byte count.
+ * With brightness (or anything else) mapped through the handle's lookup table
+ * it's one more load per byte - the choice is made once for the whole run
+ * rather than per byte.
+ *
+ * When dithering the 16 bit value plus what was left over last time is rounded
+ * down to 8 bits and the remainder carried to the next refresh, so over a few
+ * refreshes the average is the 16 bit value.
+ */
+static inline ws2812_dmaTypeDef* ws2812_encode(ws2812_handleTypeDef *ws2812, uint32_t offset, uint32_t bytes, ws2812_dmaTypeDef *dma_buffer_pointer) {
+
+    if (ws2812->index != NULL) {
+        return ws2812_encode_palette(ws2812, offset, bytes, dma_buffer_pointer);
+    } else if (ws2812->value16 != NULL) {
+        const uint16_t *value16 = &ws2812->value16[offset];
+        uint8_t *error = &ws2812->error[offset];
+        for (uint32_t i = 0; i < bytes; i++) {
+            uint32_t v = value16[i] + error[i];
+            if (v > 0xFFFF) { // Full on is full on
+                v = 0xFFFF;
+            }
+            error[i] = v & 0xFF;
+            memcpy(dma_buffer_pointer, color_value[v >> 8], sizeof(color_value[0]));
+            dma_buffer_pointer += 8; // next 8 bits
+        }
+    } else if (ws2812->use_lut) {
+        const uint8_t *led = &ws2812->front[offset];
+        const uint8_t *lut = ws2812->lut;
+        for (uint32_t i = 0; i < bytes; i++) {
+            memcpy(dma_buffer_pointer, color_value[lut[led[i]]], sizeof(color_value[0]));
+            dma_buffer_pointer += 8; // next 8 bits
+        }
+    } else {
+        const uint8_t *led = &ws2812->front[offset];
+        for (uint32_t i = 0; i < bytes; i++) {
+            // Copy values from the pre-filled color_value buffer
+            memcpy(dma_buffer_pointer, color_value[led[i]], sizeof(color_value[0])); // Lookup the actual buffer data
+            dma_buffer_pointer += 8; // next 8 bits
+        }
+    }
+
+    return dma_buffer_pointer;
+
+}
+
+/*
+ * Transfers the DMA has done into the half that is being sent while the half at
+ * dma_buffer_pointer is updated.
+ */
+static inline uint16_t ws2812_dma_done(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *dma_buffer_pointer) {
+    uint16_t length = ws2812->buffer_size * 2;
+    uint16_t pos = length - __HAL_DMA_GET_COUNTER(ws2812->timer->hdma[WS2812_DMA_ID(ws2812->channel)]);
+    uint16_t sending = dma_buffer_pointer == ws2812->dma_buffer ? ws2812->buffer_size : 0;
+    return (pos + length - sending) % length;
+}
+
+#ifdef WS2812_STATS
+static inline void ws2812_cycles_add(ws2812_cyclesTypeDef *cycles, uint32_t value) {
+    if (value < cycles->min) {
+        cycles->min = value;
+    }
+    if (value > cycles->max) {
+        cycles->max = value;
+    }
+    ++cycles->cnt;
+    cycles->sum += value;
+}
+
+void ws2812_reset_stats(ws2812_handleTypeDef *ws2812) {
+    memset(&ws2812->stats, 0, sizeof(ws2812->stats));
+    ws2812->stats.callback.min = UINT32_MAX;
+    for (uint8_t i = 0; i < 3; i++) {
+        ws2812->stats.state[i].min = UINT32_MAX;
+    }
+}
 #endif
 
+/*
+ * Leds in single buffer mode pick up changes directly - in double buffer mode
+ * only on commit.  Leds is one past the last led changed, the next frame (or
+ * the next commit) sends at least that many leds in partial refresh mode.
+ */
+static inline void ws2812_set_dirty(ws2812_handleTypeDef *ws2812, uint16_t leds) {
+    if (ws2812->front == ws2812->led) {
+        if (leds > ws2812->send_leds) {
+            ws2812->send_leds = leds;
+        }
+        ws2812->is_dirty = true;
+        ws2812_wake(ws2812);
+    } else if (leds > ws2812->dirty_leds) {
+        ws2812->dirty_leds = leds;
+    }
+}
+
+// Send all leds on the next frame - after changes not made through the led values
+static inline void ws2812_set_dirty_all(ws2812_handleTypeDef *ws2812) {
+    ws2812->send_leds = ws2812->leds;
+    ws2812->is_dirty = true;
+    ws2812_wake(ws2812);
+}
+
+// Latch and start sending data - only up to the last led changed in partial refresh mode
+static inline void ws2812_start_frame(ws2812_handleTypeDef *ws2812) {
+    ws2812->is_dirty = false;
+    ws2812_latch(ws2812);
+    ws2812->frame_leds = ws2812->partial && ws2812->value16 == NULL ? ws2812->send_leds : ws2812->leds;
+    ws2812->send_leds = 0;
+    ws2812->led_state = LED_DAT;
+}
+
+/*
+ * The DMA has sent (part of) a half that wasn't updated in time.  Send zeros for
+ * the rest of it, which latches whatever the leds got, and send the whole frame
+ * again after the reset.
+ */
+static void ws2812_underrun(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *dma_buffer_pointer) {
+    memset(dma_buffer_pointer, 0, sizeof(ws2812_dmaTypeDef) * ws2812->buffer_size);
+    ++ws2812->underruns;
+    ws2812->led_cnt = 0;
+    ws2812->res_cnt = 0;
+    ws2812->zero_halves = 1;
+    ws2812_set_dirty_all(ws2812);
+    ws2812->led_state = LED_RES;
+}
+
+/*
+ * Fill the next half of the dma buffer - the state machine behind
+ * ws2812_update_buffer without the timing checks.
+ */
+static inline void ws2812_next_half(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *dma_buffer_pointer) {
+
     // A simple state machine - we're either resetting (two buffers worth of zeros),
     // idle (just winging out zero buffers) or
     // we are transmitting data for the "current" led.
 
-	++ws2812->dma_cbs;
-
-    if (ws2812->led_state == LED_RES) { // Latch state - 10 or more full buffers of zeros
+    if (ws2812->led_state == LED_RES) { // Latch state - 10 or more full 24-bit cycles of zeros
 
         // This one is simple - we got a bunch of zeros of the right size - just throw
         // that into the buffer.  Twice will do (two half buffers).
         if (ws2812->zero_halves < 2) {
-            memset(dma_buffer_pointer, 0, 2 * BUFFER_SIZE); // Fill the buffer with zeros
+            memset(dma_buffer_pointer, 0, sizeof(ws2812_dmaTypeDef) * ws2812->buffer_size); // Fill the buffer with zeros
             ws2812->zero_halves++; // We only need to update two half buffers
         }
 
         ws2812->res_cnt++;
 
-        if (ws2812->res_cnt >= LED_RESET_CYCLES) { // done enough reset cycles - move to next state
+        if (ws2812->res_cnt >= ws2812->res_halves) { // done enough reset cycles - move to next state
             ws2812->led_cnt = 0;	// prepare to send data
-            if (ws2812->is_dirty) {
-                ws2812->is_dirty = false;
-                ws2812->led_state = LED_DAT;
+            ws2812->res_halves = LED_RESET_HALVES;
+            ws2812_displayed(ws2812); // Previous frame is now latched by the leds
+            if (ws2812->is_dirty || ws2812->value16 != NULL) { // Dithering never rests
+                ws2812_start_frame(ws2812);
             } else {
                 ws2812->led_state = LED_IDL;
             }
@@ -69,29 +266,33 @@ inline void ws2812_update_buffer(ws2812_handleTypeDef *ws2812, uint16_t *dma_buf
 
     } else if (ws2812->led_state == LED_IDL) { // idle state
 
-        if (ws2812->is_dirty) { // we do nothing here except waiting for a dirty flag
-            ws2812->is_dirty = false;
-            ws2812->led_state = LED_DAT; // when dirty - start processing data
+        if (ws2812->is_dirty || ws2812->value16 != NULL) { // we do nothing here except waiting for a dirty flag
+            ws2812_start_frame(ws2812); // when dirty - start processing data
+        } else if (ws2812->idle_stop && ++ws2812->res_cnt >= LED_RESET_HALVES + 2) {
+            // Nothing to do until something changes.  Only the halves up to the one before
+            // the one being sent are out - two more and a whole reset has been.
+            ws2812_stop(ws2812);
         }
 
     } else { // LED_DAT
 
         ++ws2812->dat_cbs;
 
-        // First let's deal with the current LED
-        uint8_t *led = (uint8_t*) &ws2812->led[3 * ws2812->led_cnt];
-
-        for (uint8_t c = 0; c < 3; c++) { // Deal with the 3 color leds in one led package
+        // Deal with the next WS2812_LEDS_PER_BUFFER leds - or what is left of them
+        uint16_t count = ws2812->frame_leds - ws2812->led_cnt;
+        if (count > WS2812_LEDS_PER_BUFFER) {
+            count = WS2812_LEDS_PER_BUFFER;
+        }
 
-            // Copy values from the pre-filled color_value buffer
-            memcpy(dma_buffer_pointer, color_value[led[c]], 16); // Lookup the actual buffer data
-            dma_buffer_pointer += 8; // next 8 bytes
+        dma_buffer_pointer = ws2812_encode(ws2812, ws2812->bpp * ws2812->led_cnt, ws2812->bpp * count, dma_buffer_pointer);
+        ws2812->led_cnt += count;
 
+        if (count < WS2812_LEDS_PER_BUFFER) { // Past the last led - pad the rest with zeros
+            memset(dma_buffer_pointer, 0, sizeof(ws2812_dmaTypeDef) * 8 * ws2812->bpp * (WS2812_LEDS_PER_BUFFER - count));
         }
 
-        // Now move to next LED switching to reset state when all leds have been updated
-        ws2812->led_cnt++; // Next led
-        if (ws2812->led_cnt >= ws2812->leds) { // reached top
+        // Switch to reset state when all leds have been updated
+        if (ws2812->led_cnt >= ws2812->frame_leds) { // reached top
             ws2812->led_cnt = 0; // back to first
             ws2812->zero_halves = 0;
             ws2812->res_cnt = 0;
@@ -100,24 +301,627 @@ inline void ws2812_update_buffer(ws2812_handleTypeDef *ws2812, uint16_t *dma_buf
 
     }
 
+}
+
+/*
+ * Update next 24 or 32 bits (per led) in the dma buffer - assume dma_buffer_pointer is pointing
+ * to the buffer that is safe to update.  The dma_buffer_pointer and the call to
+ * this function is handled by the dma callbacks.
+ */
+inline void ws2812_update_buffer(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *dma_buffer_pointer) {
+
+#ifdef BUFF_GPIO_Port
+	HAL_GPIO_WritePin(BUFF_GPIO_Port, BUFF_Pin, GPIO_PIN_SET);
+#endif
+
+    ws2812_stateTypeDef state = ws2812->led_state;
+
+#ifdef WS2812_STATS
+    uint32_t start = DWT->CYCCNT;
+    uint16_t late = ws2812_dma_done(ws2812, dma_buffer_pointer);
+#endif
+
+	++ws2812->dma_cbs;
+
+    // Too late if the DMA already got to this half - only matters when sending data.  Checked
+    // before encoding so nothing new goes into a half partly sent, and again after it in case
+    // encoding took longer than the other half.
+    uint8_t underrun = state == LED_DAT && ws2812_dma_done(ws2812, dma_buffer_pointer) >= ws2812->buffer_size;
+    if (!underrun) {
+        ws2812_next_half(ws2812, dma_buffer_pointer);
+        underrun = state == LED_DAT && ws2812_dma_done(ws2812, dma_buffer_pointer) >= ws2812->buffer_size;
+    }
+    if (underrun) {
+        ws2812_underrun(ws2812, dma_buffer_pointer);
+    }
+
+#ifdef WS2812_STATS
+    uint32_t cycles = DWT->CYCCNT - start;
+    uint16_t done = ws2812_dma_done(ws2812, dma_buffer_pointer);
+    ws2812_cycles_add(&ws2812->stats.callback, cycles);
+    ws2812_cycles_add(&ws2812->stats.state[state], cycles);
+    if (late > ws2812->stats.late_max) {
+        ws2812->stats.late_max = late;
+    }
+    if (done > ws2812->stats.done_max) {
+        ws2812->stats.done_max = done;
+    }
+#endif
+
 #ifdef BUFF_GPIO_Port
 	HAL_GPIO_WritePin(BUFF_GPIO_Port, BUFF_Pin, GPIO_PIN_RESET);
 #endif
 
 }
 
+/*
+ * Encode the entire frame into the frame buffer behind the reset period.  Called
+ * when the DMA wraps around and starts sending the reset period, which gives
+ * LED_RESET_CYCLES worth of head start - encoding is a lot faster than the DMA
+ * is sending so it will never catch up with us.
+ */
+static void ws2812_encode_frame(ws2812_handleTypeDef *ws2812) {
+
+    ws2812_encode(ws2812, 0, ws2812->bpp * ws2812->leds, &ws2812->frame_buffer[LED_RESET_CYCLES * 24]);
+
+    ++ws2812->enc_frames;
+
+}
+
+// Done sending first half of the DMA buffer - this can now safely be updated
+void ws2812_dma_half_callback(ws2812_handleTypeDef *ws2812) {
+    if (ws2812->frame_buffer == NULL) {
+        ws2812_update_buffer(ws2812, &ws2812->dma_buffer[0]);
+    }
+}
+
+// Done sending the second half of the DMA buffer - this can now safely be updated.
+// With a frame buffer the DMA has just wrapped around to the reset period.
+void ws2812_dma_full_callback(ws2812_handleTypeDef *ws2812) {
+    if (ws2812->frame_buffer == NULL) {
+        ws2812_update_buffer(ws2812, &ws2812->dma_buffer[ws2812->buffer_size]);
+    } else {
+        ++ws2812->dma_cbs;
+        if (ws2812->zero_frames > 0) { // Leds still coming up - the frame latched goes out once they are
+            if (--ws2812->zero_frames == 0) {
+                ws2812_encode_frame(ws2812);
+            }
+        } else {
+            ws2812_displayed(ws2812); // Close enough - the reset period has just started
+            if (ws2812->is_dirty || ws2812->value16 != NULL) {
+                ws2812->is_dirty = false;
+                ws2812_latch(ws2812);
+                ws2812_encode_frame(ws2812);
+            } else if (ws2812->idle_stop) { // Stop while sending the reset period
+                ws2812_stop(ws2812);
+            }
+        }
+    }
+}
+
+ws2812_handleTypeDef* ws2812_find(TIM_HandleTypeDef *htim) {
+    for (uint8_t i = 0; i < ws2812_strand_cnt; i++) {
+        ws2812_handleTypeDef *ws2812 = ws2812_strands[i];
+        if (ws2812->timer == htim && WS2812_ACTIVE_CHANNEL(ws2812->channel) == (uint32_t) htim->Channel) {
+            return ws2812;
+        }
+    }
+    return NULL;
+}
+
+void ws2812_tim_half_callback(TIM_HandleTypeDef *htim) {
+    ws2812_handleTypeDef *ws2812 = ws2812_find(htim);
+    if (ws2812 != NULL) {
+        ws2812_dma_half_callback(ws2812);
+    }
+}
+
+void ws2812_tim_full_callback(TIM_HandleTypeDef *htim) {
+    ws2812_handleTypeDef *ws2812 = ws2812_find(htim);
+    if (ws2812 != NULL) {
+        ws2812_dma_full_callback(ws2812);
+    }
+}
+
+#ifdef WS2812_HAL_CALLBACKS
+void HAL_TIM_PWM_PulseFinishedHalfCpltCallback(TIM_HandleTypeDef *htim) {
+    ws2812_tim_half_callback(htim);
+}
+
+void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim) {
+    ws2812_tim_full_callback(htim);
+}
+#endif
+
+// Switch the led power back on - true when it was off.  The leds forgot everything.
+static uint8_t ws2812_power_up(ws2812_handleTypeDef *ws2812) {
+    if (ws2812->powered) {
+        return false;
+    }
+    HAL_GPIO_WritePin(ws2812->power_port, ws2812->power_pin, ws2812->power_on);
+    ws2812->powered = true;
+    ws2812->send_leds = ws2812->leds;
+    return true;
+}
+
+// Start the DMA on a zeroed buffer from the top of the reset period
+static void ws2812_start(ws2812_handleTypeDef *ws2812) {
+
+    memset(ws2812->dma_buffer, 0, sizeof(ws2812->dma_buffer)); // Handle might not be static
+    ws2812->led_cnt = 0;
+    ws2812->res_cnt = 0;
+    ws2812->res_halves = ws2812_power_up(ws2812) ? WS2812_POWER_ON_HALVES : LED_RESET_HALVES;
+    ws2812->zero_halves = 2;
+    ws2812->led_state = LED_RES;
+    ws2812->stopped = false;
+
+    HAL_TIM_PWM_Start_DMA(ws2812->timer, ws2812->channel, (uint32_t*) ws2812->dma_buffer, ws2812->buffer_size * 2);
+
+}
+
+// Encode and start streaming the frame buffer from the top of the reset period.
+// After switching the power on it is sent as zeros for at least WS2812_POWER_ON_HALVES.
+static void ws2812_start_frame_buffer(ws2812_handleTypeDef *ws2812) {
+
+    uint32_t size = WS2812_FRAME_BUFFER_SIZE_BPP(ws2812->leds, ws2812->bpp);
+
+    if (ws2812_power_up(ws2812)) {
+        memset(&ws2812->frame_buffer[LED_RESET_CYCLES * 24], 0, sizeof(ws2812_dmaTypeDef) * ws2812->leds * ws2812->bpp * 8);
+        ws2812->zero_frames = (WS2812_POWER_ON_HALVES * ws2812->buffer_size + size - 1) / size;
+    } else {
+        ws2812->zero_frames = 0;
+        ws2812_encode_frame(ws2812);
+    }
+    ws2812->stopped = false;
+
+    HAL_TIM_PWM_Start_DMA(ws2812->timer, ws2812->channel, (uint32_t*) ws2812->frame_buffer, size);
+
+    // Only the wrap around is of interest
+    __HAL_DMA_DISABLE_IT(ws2812->timer->hdma[WS2812_DMA_ID(ws2812->channel)], DMA_IT_HT);
+
+}
+
+/*
+ * Restart the DMA stopped when idle.  It was stopped with LED_RESET_HALVES of
+ * zeros sent after the last frame, so the data goes straight into both halves.
+ */
+static void ws2812_restart(ws2812_handleTypeDef *ws2812) {
+
+    if (ws2812->frame_buffer != NULL) {
+        ws2812->is_dirty = false;
+        ws2812_latch(ws2812);
+        ws2812_start_frame_buffer(ws2812);
+        return;
+    }
+
+    if (!ws2812->powered) { // Give the leds time to come up
+        ws2812_start(ws2812);
+        return;
+    }
+
+    ws2812->led_cnt = 0;
+    ws2812_start_frame(ws2812);
+    ws2812_next_half(ws2812, &ws2812->dma_buffer[0]);
+    ws2812_next_half(ws2812, &ws2812->dma_buffer[ws2812->buffer_size]);
+    ws2812->stopped = false;
+
+    HAL_TIM_PWM_Start_DMA(ws2812->timer, ws2812->channel, (uint32_t*) ws2812->dma_buffer, ws2812->buffer_size * 2);
+
+}
+
+// Stop the DMA from a callback when there's nothing to send
+static void ws2812_stop(ws2812_handleTypeDef *ws2812) {
+    HAL_TIM_PWM_Stop_DMA(ws2812->timer, ws2812->channel);
+    ws2812->idle_since = HAL_GetTick();
+    ws2812->dark_checked = false;
+    ws2812->stopped = true;
+    ws2812_idle_callback(ws2812);
+}
+
+__weak void ws2812_idle_callback(ws2812_handleTypeDef *ws2812) {
+    UNUSED(ws2812);
+}
+
+/*
+ * Called after setting the dirty flag.  A callback either saw the flag or had
+ * stopped the DMA before - interrupts are off while checking so it can't stop
+ * it in between.
+ */
+static void ws2812_wake(ws2812_handleTypeDef *ws2812) {
+    if (ws2812->stopped) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (ws2812->stopped) {
+            ws2812_restart(ws2812);
+        }
+        __set_PRIMASK(primask);
+    }
+}
+
+ws2812_resultTypeDef ws2812_set_idle_stop(ws2812_handleTypeDef *ws2812, uint8_t idle_stop) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    ws2812->idle_stop = idle_stop;
+    if (!idle_stop && ws2812->stopped) {
+        ws2812_set_dirty_all(ws2812); // Back to running all the time
+    }
+    return res;
+}
+
+ws2812_resultTypeDef ws2812_set_format(ws2812_handleTypeDef *ws2812, ws2812_formatTypeDef format, uint8_t *led) {
+
+    if (format >= WS2812_FORMATS || ws2812_formats[format][0] > WS2812_MAX_BPP) {
+        return WS2812_Err;
+    }
+
+    // Everything else holding led values has been sized for the current format
+    if (ws2812->front != ws2812->led || ws2812->value16 != NULL || ws2812->frame_buffer != NULL) {
+        return WS2812_Err;
+    }
+
+    uint8_t bpp = ws2812_formats[format][0];
+
+    // Colors are kept per palette entry in palette mode
+    uint32_t entries = ws2812->index != NULL ? WS2812_PALETTE_ENTRIES(ws2812->index_bits) : ws2812->leds;
+    uint8_t *values = ws2812->index != NULL ? ws2812->palette : ws2812->led;
+
+    if (led != NULL) {
+        values = led;
+        ws2812->led_size = entries * bpp;
+    } else if (entries * bpp > ws2812->led_size) {
+        return WS2812_Mem; // Need more room for the led values
+    }
+
+    HAL_TIM_PWM_Stop_DMA(ws2812->timer, ws2812->channel);
+    ws2812->stopped = false;
+
+    ws2812->bpp = bpp;
+    memcpy(ws2812->offset, &ws2812_formats[format][1], sizeof(ws2812->offset));
+    ws2812->buffer_size = bpp * 8 * WS2812_LEDS_PER_BUFFER;
+
+    if (ws2812->index != NULL) {
+        ws2812->palette = values;
+    } else {
+        ws2812->led = ws2812->front = values;
+    }
+    memset(values, 0, entries * bpp);
+    ws2812->is_dirty = false;
+    ws2812_start(ws2812);
+
+    return WS2812_Ok;
+
+}
+
+// Add handle to the registry - replacing whatever was running on the same timer channel before
+static ws2812_resultTypeDef ws2812_register(ws2812_handleTypeDef *ws2812) {
+    for (uint8_t i = 0; i < ws2812_strand_cnt; i++) {
+        if (ws2812_strands[i] == ws2812 || (ws2812_strands[i]->timer == ws2812->timer && ws2812_strands[i]->channel == ws2812->channel)) {
+            ws2812_strands[i] = ws2812;
+            return WS2812_Ok;
+        }
+    }
+    if (ws2812_strand_cnt >= WS2812_MAX_STRANDS) {
+        return WS2812_Err;
+    }
+    ws2812_strands[ws2812_strand_cnt++] = ws2812;
+    return WS2812_Ok;
+}
+
+ws2812_resultTypeDef ws2812_set_frame_buffer(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *frame_buffer, uint32_t size) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    uint32_t frame_size = WS2812_FRAME_BUFFER_SIZE_BPP(ws2812->leds, ws2812->bpp);
+
+    if (frame_buffer != NULL && (size < frame_size || size > UINT16_MAX)) {
+        return WS2812_Err; // Too small or too large for a single DMA transfer
+    }
+
+    HAL_TIM_PWM_Stop_DMA(ws2812->timer, ws2812->channel);
+    ws2812->stopped = false;
+
+    ws2812->frame_buffer = frame_buffer;
+    ws2812->frame_size = size;
+
+    if (frame_buffer != NULL) {
+
+        // Reset period and trailing zero never change - encode the rest right away
+        memset(frame_buffer, 0, sizeof(ws2812_dmaTypeDef) * size);
+        ws2812->is_dirty = false;
+        ws2812_start_frame_buffer(ws2812);
+
+    } else {
+
+        // Back to encoding per callback - start over with a reset
+        ws2812_set_dirty_all(ws2812);
+        ws2812_start(ws2812);
+
+    }
+
+    return res;
+
+}
+
+ws2812_resultTypeDef ws2812_set_double_buffer(ws2812_handleTypeDef *ws2812, uint8_t *front) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    if (ws2812->index != NULL) {
+        return WS2812_Err; // No led values to double buffer
+    }
+
+    if (front != NULL) {
+        memcpy(front, ws2812->led, ws2812->leds * ws2812->bpp); // Start off with what we got
+        ws2812->latched = ws2812->commits;
+        ws2812->front = front;
+    } else if (ws2812->front != ws2812->led) {
+        // Keep the buffer with the last commit, whichever of the two that is by now
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (ws2812->latched == ws2812->commits) {
+            ws2812->led = ws2812->front;
+        } else {
+            ws2812->front = ws2812->led;
+            ws2812->latched = ws2812->commits;
+        }
+        __set_PRIMASK(primask);
+        ws2812_set_dirty_all(ws2812);
+    }
+
+    return res;
+
+}
+
+ws2812_resultTypeDef ws2812_commit(ws2812_handleTypeDef *ws2812) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (ws2812->dirty_leds > ws2812->send_leds) {
+        ws2812->send_leds = ws2812->dirty_leds;
+    }
+    ws2812->dirty_leds = 0;
+    ++ws2812->commits; // Commit first, the dirty flag makes the dma callback pick it up
+    ws2812->is_dirty = true;
+    ws2812_wake(ws2812);
+    return res;
+}
+
+ws2812_resultTypeDef ws2812_set_power_pin(ws2812_handleTypeDef *ws2812, GPIO_TypeDef *port, uint16_t pin, GPIO_PinState on, uint32_t delay) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    if (!ws2812->powered) {
+        ws2812_set_dirty_all(ws2812); // Switch on with the old pin first
+    }
+
+    ws2812->power_port = port;
+    ws2812->power_pin = pin;
+    ws2812->power_on = on;
+    ws2812->power_delay = delay;
+
+    if (port != NULL) {
+        HAL_GPIO_WritePin(port, pin, on);
+    }
+
+    return res;
+
+}
+
+// All leds off - after brightness and gamma
+static uint8_t ws2812_is_dark(ws2812_handleTypeDef *ws2812) {
+    uint8_t bpp = ws2812->bpp;
+    for (uint32_t i = 0; i < ws2812->leds * bpp; i++) {
+        uint8_t value = ws2812->index != NULL ? ws2812->palette[ws2812_palette_entry(ws2812, i / bpp) * bpp + i % bpp] : ws2812->front[i];
+        if ((ws2812->use_lut ? ws2812->lut[value] : value) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ws2812_power_tick(ws2812_handleTypeDef *ws2812) {
+
+    if (ws2812->power_port == NULL || !ws2812->powered || !ws2812->stopped) {
+        return;
+    }
+
+    if (!ws2812->dark_checked) { // Once per stop - any change restarts the DMA
+        ws2812->dark = ws2812_is_dark(ws2812);
+        ws2812->dark_checked = true;
+    }
+
+    if (ws2812->dark && HAL_GetTick() - ws2812->idle_since >= ws2812->power_delay) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (ws2812->stopped) { // Still nothing to send
+            HAL_GPIO_WritePin(ws2812->power_port, ws2812->power_pin, ws2812->power_on == GPIO_PIN_SET ? GPIO_PIN_RESET : GPIO_PIN_SET);
+            ws2812->powered = false;
+        }
+        __set_PRIMASK(primask);
+    }
+
+}
+
+ws2812_powerTypeDef ws2812_power_state(ws2812_handleTypeDef *ws2812) {
+    if (!ws2812->stopped) {
+        return WS2812_POWER_BUSY;
+    }
+    return ws2812->powered ? WS2812_POWER_IDLE : WS2812_POWER_OFF;
+}
+
+ws2812_powerTypeDef ws2812_power_state_all(void) {
+    ws2812_powerTypeDef state = WS2812_POWER_OFF;
+    for (uint8_t i = 0; i < ws2812_strand_cnt; i++) {
+        ws2812_powerTypeDef strand = ws2812_power_state(ws2812_strands[i]);
+        if (strand < state) {
+            state = strand;
+        }
+    }
+    return state;
+}
+
+uint32_t ws2812_next_activity(ws2812_handleTypeDef *ws2812) {
+
+    if (!ws2812->stopped) {
+        return 0;
+    }
+
+    if (ws2812->power_port == NULL || !ws2812->powered || (ws2812->dark_checked && !ws2812->dark)) {
+        return WS2812_NEVER;
+    }
+
+    uint32_t idle = HAL_GetTick() - ws2812->idle_since;
+    return idle < ws2812->power_delay ? ws2812->power_delay - idle : 0;
+
+}
+
+uint32_t ws2812_next_activity_all(void) {
+    uint32_t next = WS2812_NEVER;
+    for (uint8_t i = 0; i < ws2812_strand_cnt; i++) {
+        uint32_t strand = ws2812_next_activity(ws2812_strands[i]);
+        if (strand < next) {
+            next = strand;
+        }
+    }
+    return next;
+}
+
+ws2812_resultTypeDef ws2812_set_partial(ws2812_handleTypeDef *ws2812, uint8_t partial) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    ws2812->partial = partial;
+    ws2812_set_dirty_all(ws2812); // Leds past the last one changed might never have been sent
+    return res;
+}
+
+uint8_t ws2812_is_displayed(ws2812_handleTypeDef *ws2812) {
+    return ws2812->displayed == ws2812->commits;
+}
+
+/*
+ * Rebuild the lookup table from gamma and brightness - both are folded into the
+ * one table so gamma correction costs nothing extra per led.
+ */
+static void ws2812_update_lut(ws2812_handleTypeDef *ws2812) {
+
+    uint8_t brightness = ws2812->brightness;
+    const uint8_t *gamma = ws2812->gamma;
+
+    if (brightness < 255 || gamma != NULL) {
+        // Fill the table before using it.  A change while a frame is being sent might
+        // give a few leds the previous values but the refresh right after fixes that.
+        for (uint16_t v = 0; v < 256; v++) {
+            uint8_t g = gamma != NULL ? gamma[v] : v;
+            ws2812->lut[v] = (g * brightness + 127) / 255;
+        }
+        ws2812->use_lut = true;
+    } else {
+        ws2812->use_lut = false; // Linear at full brightness - straight through
+    }
+
+    ws2812_set_dirty_all(ws2812); // Send the front buffer again - no need to touch the led values
+
+}
+
+ws2812_resultTypeDef ws2812_set_brightness(ws2812_handleTypeDef *ws2812, uint8_t brightness) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    ws2812->brightness = brightness;
+    ws2812_update_lut(ws2812);
+    return res;
+}
+
+ws2812_resultTypeDef ws2812_set_gamma(ws2812_handleTypeDef *ws2812, const uint8_t *gamma) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    ws2812->gamma = gamma;
+    ws2812_update_lut(ws2812);
+    return res;
+}
+
+ws2812_resultTypeDef ws2812_set_dither(ws2812_handleTypeDef *ws2812, uint16_t *value16, uint8_t *error) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    if (ws2812->index != NULL) {
+        return WS2812_Err; // Palette colors only have 8 bits
+    }
+
+    if (value16 != NULL) {
+        for (uint32_t i = 0; i < ws2812->bpp * ws2812->leds; i++) {
+            value16[i] = ws2812->front[i] << 8; // Start off with what we got
+            error[i] = i * 97; // Spread the starting points so leds don't all step up at the same refresh
+        }
+        ws2812->error = error;
+    }
+
+    ws2812->value16 = value16;
+    ws2812_set_dirty_all(ws2812);
+
+    return res;
+
+}
+
+ws2812_resultTypeDef setLedValues16(ws2812_handleTypeDef *ws2812, uint16_t led, uint16_t r, uint16_t g, uint16_t b) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (led < ws2812->leds && ws2812->value16 != NULL) {
+        uint16_t *value16 = &ws2812->value16[ws2812->bpp * led];
+        value16[ws2812->offset[RL]] = r;
+        value16[ws2812->offset[GL]] = g;
+        value16[ws2812->offset[BL]] = b;
+    } else {
+        res = WS2812_Err;
+    }
+    return res;
+}
+
+ws2812_resultTypeDef setLedValues16W(ws2812_handleTypeDef *ws2812, uint16_t led, uint16_t r, uint16_t g, uint16_t b, uint16_t w) {
+    ws2812_resultTypeDef res = setLedValues16(ws2812, led, r, g, b);
+    if (res == WS2812_Ok && ws2812->bpp == 4) {
+        ws2812->value16[4 * led + ws2812->offset[WL]] = w;
+    }
+    return res;
+}
+
+#ifdef DWT
+/*
+ * Average cycles spent encoding one led in the current mode, measured with the
+ * DWT cycle counter.  Has to stay well within the 30 us it takes to send one led
+ * divided by the interrupt share the application can afford.  When dithering this
+ * is one refresh worth of error accumulation.
+ */
+uint32_t ws2812_benchmark(ws2812_handleTypeDef *ws2812) {
+
+    ws2812_dmaTypeDef buffer[WS2812_MAX_BPP * 8];
+
+    if (ws2812->leds == 0) {
+        return 0;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint16_t led = 0; led < ws2812->leds; led++) {
+        ws2812_encode(ws2812, ws2812->bpp * led, ws2812->bpp, buffer);
+    }
+
+    return (DWT->CYCCNT - start) / ws2812->leds;
+
+}
+#endif
+
 ws2812_resultTypeDef zeroLedValues(ws2812_handleTypeDef *ws2812) {
     ws2812_resultTypeDef res = WS2812_Ok;
-    memset(ws2812->led, 0, ws2812->leds * 3); // Zero it all
-    ws2812->is_dirty = true; // Mark buffer dirty
+    if (ws2812->index != NULL) { // All leds back to entry 0
+        memset(ws2812->index, 0, (ws2812->leds * ws2812->index_bits + 7) / 8);
+    } else {
+        memset(ws2812->led, 0, ws2812->leds * ws2812->bpp); // Zero it all
+    }
+    ws2812_set_dirty(ws2812, ws2812->leds); // Mark buffer dirty
     return res;
 }
 
 ws2812_resultTypeDef setLedValue(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t col, uint8_t value) {
     ws2812_resultTypeDef res = WS2812_Ok;
-    if (led < ws2812->leds) {
-        ws2812->led[3 * led + col] = value;
-        ws2812->is_dirty = true; // Mark buffer dirty
+    if (led < ws2812->leds && col < ws2812->bpp && ws2812->led != NULL) { // WL is only there on RGBW leds
+        ws2812->led[ws2812->bpp * led + ws2812->offset[col]] = value;
+        ws2812_set_dirty(ws2812, led + 1); // Mark buffer dirty
     } else {
         res = WS2812_Err;
     }
@@ -128,20 +932,90 @@ ws2812_resultTypeDef setLedValue(ws2812_handleTypeDef *ws2812, uint16_t led, uin
 // handle updating the dma buffer when needed
 ws2812_resultTypeDef setLedValues(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t r, uint8_t g, uint8_t b) {
     ws2812_resultTypeDef res = WS2812_Ok;
-    if (led < ws2812->leds) {
-        ws2812->led[3 * led + RL] = r;
-        ws2812->led[3 * led + GL] = g;
-        ws2812->led[3 * led + BL] = b;
-        ws2812->is_dirty = true; // Mark buffer dirty
+    if (led < ws2812->leds && ws2812->led != NULL) {
+        uint8_t *p = &ws2812->led[ws2812->bpp * led];
+        p[ws2812->offset[RL]] = r;
+        p[ws2812->offset[GL]] = g;
+        p[ws2812->offset[BL]] = b;
+        ws2812_set_dirty(ws2812, led + 1); // Mark buffer dirty
     } else {
         res = WS2812_Err;
     }
     return res;
 }
 
-ws2812_resultTypeDef ws2812_init(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds) {
+ws2812_resultTypeDef setLedValuesW(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (led < ws2812->leds && ws2812->led != NULL) {
+        uint8_t *p = &ws2812->led[ws2812->bpp * led];
+        p[ws2812->offset[RL]] = r;
+        p[ws2812->offset[GL]] = g;
+        p[ws2812->offset[BL]] = b;
+        if (ws2812->bpp == 4) {
+            p[ws2812->offset[WL]] = w;
+        }
+        ws2812_set_dirty(ws2812, led + 1); // Only with all of the led in - this might restart the DMA
+    } else {
+        res = WS2812_Err;
+    }
+    return res;
+}
 
+ws2812_resultTypeDef ws2812_set_changed(ws2812_handleTypeDef *ws2812, uint16_t leds) {
     ws2812_resultTypeDef res = WS2812_Ok;
+    ws2812_set_dirty(ws2812, leds < ws2812->leds ? leds : ws2812->leds);
+    return res;
+}
+
+ws2812_resultTypeDef setLedIndex(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t index) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (led < ws2812->leds && ws2812->index != NULL && index < WS2812_PALETTE_ENTRIES(ws2812->index_bits)) {
+        if (ws2812->index_bits == 8) {
+            ws2812->index[led] = index;
+        } else {
+            uint8_t shift = (led & 1) << 2;
+            ws2812->index[led >> 1] = (ws2812->index[led >> 1] & ~(0x0f << shift)) | (index << shift);
+        }
+        ws2812_set_dirty(ws2812, led + 1);
+    } else {
+        res = WS2812_Err;
+    }
+    return res;
+}
+
+ws2812_resultTypeDef ws2812_set_palette_color(ws2812_handleTypeDef *ws2812, uint8_t entry, uint8_t r, uint8_t g, uint8_t b) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (ws2812->index != NULL && entry < WS2812_PALETTE_ENTRIES(ws2812->index_bits)) {
+        uint8_t *p = &ws2812->palette[ws2812->bpp * entry];
+        p[ws2812->offset[RL]] = r;
+        p[ws2812->offset[GL]] = g;
+        p[ws2812->offset[BL]] = b;
+        ws2812_set_dirty_all(ws2812); // Any led could be using it
+    } else {
+        res = WS2812_Err;
+    }
+    return res;
+}
+
+ws2812_resultTypeDef ws2812_set_palette_colorW(ws2812_handleTypeDef *ws2812, uint8_t entry, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (ws2812->index != NULL && entry < WS2812_PALETTE_ENTRIES(ws2812->index_bits)) {
+        uint8_t *p = &ws2812->palette[ws2812->bpp * entry];
+        p[ws2812->offset[RL]] = r;
+        p[ws2812->offset[GL]] = g;
+        p[ws2812->offset[BL]] = b;
+        if (ws2812->bpp == 4) {
+            p[ws2812->offset[WL]] = w;
+        }
+        ws2812_set_dirty_all(ws2812); // Any led could be using it - only with the whole color in
+    } else {
+        res = WS2812_Err;
+    }
+    return res;
+}
+
+// Everything but the storage for the led values - registers the handle and starts the DMA
+static ws2812_resultTypeDef ws2812_init_handle(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds) {
 
     // Store timer handle for later
     ws2812->timer = timer;
@@ -150,20 +1024,99 @@ ws2812_resultTypeDef ws2812_init(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef
     ws2812->channel = channel;
 
     ws2812->leds = leds;
+    ws2812->bpp = 3;
+    memcpy(ws2812->offset, &ws2812_formats[WS2812_GRB][1], sizeof(ws2812->offset));
+    ws2812->buffer_size = BUFFER_SIZE;
 
     ws2812->led_state = LED_RES;
     ws2812->is_dirty = 0;
+    ws2812->partial = false;
+    ws2812->idle_stop = false;
+    ws2812->stopped = false;
+    ws2812->res_halves = LED_RESET_HALVES;
+    ws2812->power_port = NULL;
+    ws2812->powered = true;
+    ws2812->send_leds = ws2812->dirty_leds = 0;
+    ws2812->frame_leds = leds;
     ws2812->zero_halves = 2;
+    ws2812->res_cnt = 0;
+    ws2812->led_cnt = 0;
+    ws2812->frame_buffer = NULL;
+    ws2812->zero_frames = 0;
+    ws2812->brightness = 255;
+    ws2812->use_lut = false;
+    ws2812->gamma = NULL;
+    ws2812->value16 = NULL;
+    ws2812->dma_cbs = ws2812->dat_cbs = ws2812->enc_frames = 0;
+    ws2812->underruns = 0;
+
+#ifdef WS2812_STATS
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    ws2812_reset_stats(ws2812);
+#endif
+
+    if (ws2812_register(ws2812) != WS2812_Ok) { // No room for another strand
+        return WS2812_Err;
+    }
+
+    ws2812->commits = ws2812->latched = ws2812->displayed = 0;
+    ws2812->latch_hook = ws2812->displayed_hook = NULL;
+    ws2812->hook_data = NULL;
+    memset(ws2812->dma_buffer, 0, sizeof(ws2812->dma_buffer)); // Handle might not be static
+
+    // Start DMA to feed the PWM with values
+    // At this point the buffer should be empty - all zeros
+    HAL_TIM_PWM_Start_DMA(timer, channel, (uint32_t*)ws2812->dma_buffer, BUFFER_SIZE * 2);
 
-    ws2812->led = malloc(leds * 3);
-    if (ws2812->led != NULL) { // Memory for led values
+    return WS2812_Ok;
 
-        memset(ws2812->led, 0, leds * 3); // Zero it all
+}
+
+ws2812_resultTypeDef ws2812_init_static(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds, uint8_t *led) {
+
+    ws2812->led = led;
+    ws2812->led_size = leds * 3;
+    memset(ws2812->led, 0, leds * 3); // Zero it all
+    ws2812->front = ws2812->led;
+    ws2812->index = NULL;
+    ws2812->palette = NULL;
+
+    return ws2812_init_handle(ws2812, timer, channel, leds);
+
+}
 
-        // Start DMA to feed the PWM with values
-        // At this point the buffer should be empty - all zeros
-        HAL_TIM_PWM_Start_DMA(timer, channel, (uint32_t*)ws2812->dma_buffer, BUFFER_SIZE * 2);
+ws2812_resultTypeDef ws2812_init_palette(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds,
+        uint8_t *index, uint8_t bits, uint8_t *palette) {
 
+    if (bits != 8 && bits != 4) {
+        return WS2812_Err;
+    }
+
+    // No led values - the palette takes their place
+    ws2812->led = ws2812->front = NULL;
+    ws2812->index = index;
+    ws2812->index_bits = bits;
+    ws2812->palette = palette;
+    ws2812->led_size = WS2812_PALETTE_ENTRIES(bits) * 3;
+    memset(index, 0, (leds * bits + 7) / 8);
+    memset(palette, 0, ws2812->led_size);
+
+    return ws2812_init_handle(ws2812, timer, channel, leds);
+
+}
+
+#ifndef WS2812_NO_MALLOC
+ws2812_resultTypeDef ws2812_init(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    uint8_t *led = malloc(leds * 3);
+    if (led != NULL) { // Memory for led values
+        res = ws2812_init_static(ws2812, timer, channel, leds, led);
+        if (res != WS2812_Ok) {
+            free(led);
+        }
     } else {
         res = WS2812_Mem;
     }
@@ -171,6 +1124,7 @@ ws2812_resultTypeDef ws2812_init(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef
     return res;
 
 }
+#endif
 
 /* 
  * vim: ts=4 nowrap
@@ -20,17 +20,84 @@
 
 #include "main.h"
 
-// Buffer allocated will be twice this
-#define BUFFER_SIZE 24
+// Number of leds encoded into each half of the DMA buffer.  Every DMA callback
+// encodes this many leds, so the interrupt rate drops by the same factor at the
+// cost of a larger buffer (48 halfwords per led).  Can be overridden in main.h.
+#ifndef WS2812_LEDS_PER_BUFFER
+#define WS2812_LEDS_PER_BUFFER 1
+#endif
+
+// Byte wide DMA buffer - define WS2812_DMA_BYTE in main.h and configure the DMA
+// with memory data width byte and peripheral data width half word.  Halves the
+// DMA buffer, the color_value table and the bus traffic.  Only works with the
+// simple channel DMA (F0/F1/F3/L4) - the F2/F4 stream DMA packs two bytes into
+// one half word transfer instead of widening them.
+#ifdef WS2812_DMA_BYTE
+typedef uint8_t ws2812_dmaTypeDef;
+#else
+typedef uint16_t ws2812_dmaTypeDef;
+#endif
+
+// Largest led handled in bytes.  Set to 4 in main.h for RGBW (SK6812) leds -
+// the DMA buffers grow by a third.
+#ifndef WS2812_MAX_BPP
+#define WS2812_MAX_BPP 3
+#endif
+
+// Half buffer for RGB leds
+#define BUFFER_SIZE (24 * WS2812_LEDS_PER_BUFFER)
+
+// Half buffer size needed for the largest led
+#define WS2812_MAX_BUFFER_SIZE (WS2812_MAX_BPP * 8 * WS2812_LEDS_PER_BUFFER)
 
 // LED on/off counts.  PWM timer is running 125 counts.  LED_CNT need to be set to the total counts in the PWM.
 #define LED_OFF 1 * LED_CNT / 3 - 1  // A bit less than 1/3
 #define LED_ON 2 * LED_CNT / 3 + 2   // A bit more than 2/3
 #define LED_RESET_CYCLES 10          // Full 24-bit cycles
 
+#if defined(WS2812_DMA_BYTE) && LED_CNT > 255
+#error "WS2812_DMA_BYTE needs a PWM period (LED_CNT) that fits in a byte"
+#endif
+
+// Half buffers of zeros covering LED_RESET_CYCLES - never less than two as both halves need clearing
+#define LED_RESET_HALVES ((LED_RESET_CYCLES + WS2812_LEDS_PER_BUFFER - 1) / WS2812_LEDS_PER_BUFFER < 2 ? 2 : \
+                          (LED_RESET_CYCLES + WS2812_LEDS_PER_BUFFER - 1) / WS2812_LEDS_PER_BUFFER)
+
+// Size (in ws2812_dmaTypeDef entries) of a pre-encoded frame buffer for a
+// string of leds - reset period, 24 (or 32) bits per led and a trailing zero
+#define WS2812_FRAME_BUFFER_SIZE_BPP(leds, bpp) (LED_RESET_CYCLES * 24 + (leds) * (bpp) * 8 + 1)
+#define WS2812_FRAME_BUFFER_SIZE(leds) WS2812_FRAME_BUFFER_SIZE_BPP(leds, 3)
+
+// Maximum number of strings (handles) driven at the same time - each on its own
+// timer channel and DMA.  Can be overridden in main.h.
+#ifndef WS2812_MAX_STRANDS
+#define WS2812_MAX_STRANDS 8
+#endif
+
+// DMA handle index and active channel (as found in htim->Channel during a callback) of a timer channel
+#define WS2812_DMA_ID(channel) (TIM_DMA_ID_CC1 + (channel) / 4)
+#define WS2812_ACTIVE_CHANNEL(channel) ((uint32_t) HAL_TIM_ACTIVE_CHANNEL_1 << ((channel) / 4))
+
+// Halves of zeros sent after switching the led power back on - about 1 ms.  In
+// frame buffer mode whole passes of the frame buffer adding up to at least as
+// many are sent as zeros.  Can be overridden in main.h.
+#ifndef WS2812_POWER_ON_HALVES
+#define WS2812_POWER_ON_HALVES ((34 + WS2812_LEDS_PER_BUFFER - 1) / WS2812_LEDS_PER_BUFFER)
+#endif
+
+// No activity pending (ws2812_next_activity)
+#define WS2812_NEVER UINT32_MAX
+
+// Callback timing statistics - define WS2812_STATS in main.h.  Uses the DWT
+// cycle counter so only on Cortex-M3 and up.
+#if defined(WS2812_STATS) && !defined(DWT)
+#error "WS2812_STATS needs the DWT cycle counter (Cortex-M3 or up)"
+#endif
+
 #define GL 0 // Green LED
 #define RL 1 // Red LED
 #define BL 2 // Blue LED
+#define WL 3 // White LED
 
 typedef enum {
     WS2812_Ok,
@@ -38,40 +105,276 @@ typedef enum {
     WS2812_Mem
 } ws2812_resultTypeDef;
 
+// Order the leds expect their colors in - sets the bytes per led as well
+typedef enum {
+    WS2812_GRB = 0,                         // WS2812B - the default
+    WS2812_RGB,                             // WS2811
+    WS2812_BRG,
+    WS2812_GRBW,                            // SK6812 RGBW
+    WS2812_RGBW,
+    WS2812_FORMATS
+} ws2812_formatTypeDef;
+
+// From busy to off - the lowest of all strings decides how deep the MCU can sleep
+typedef enum {
+    WS2812_POWER_BUSY = 0,                  // DMA running - sleep (WFI) only
+    WS2812_POWER_IDLE,                      // DMA stopped - fine to enter STOP mode
+    WS2812_POWER_OFF                        // Led power switched off as well
+} ws2812_powerTypeDef;
+
 typedef enum {
     LED_RES = 0,
     LED_IDL = 1,
     LED_DAT = 2
 } ws2812_stateTypeDef;
 
+#ifdef WS2812_STATS
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint32_t cnt;
+    uint64_t sum;
+} ws2812_cyclesTypeDef;
+
+#define WS2812_CYCLES_AVG(cycles) ((cycles).cnt > 0 ? (uint32_t) ((cycles).sum / (cycles).cnt) : 0)
+
+// Cycles spent in ws2812_update_buffer and how far the DMA got into the other
+// half meanwhile.  Each DMA transfer is one bit (1.25 us) - once the DMA is
+// buffer_size transfers in the half being written is sent and it is too late.
 typedef struct {
+    ws2812_cyclesTypeDef callback;          // All callbacks
+    ws2812_cyclesTypeDef state[3];          // Callbacks per state (on entry)
+    uint16_t late_max;                      // Most transfers done on entry
+    uint16_t done_max;                      // Most transfers done on exit
+} ws2812_statsTypeDef;
+#endif
+
+typedef struct ws2812_handle {
     TIM_HandleTypeDef *timer;               // Timer running the PWM - MUST run at 800 kHz
     uint32_t channel;                       // Timer channel
-    uint16_t dma_buffer[BUFFER_SIZE * 2];   // Fixed size DMA buffer
+    ws2812_dmaTypeDef dma_buffer[WS2812_MAX_BUFFER_SIZE * 2]; // Fixed size DMA buffer
+    uint16_t buffer_size;                   // Half of the DMA buffer in use - depends on bytes per led
     uint16_t leds;                          // Number of LEDs on the string
-    uint8_t *led;                           // Dynamically allocated array of LED RGB values
+    uint8_t bpp;                            // Bytes per led - 3 or 4
+    uint8_t offset[4];                      // Position of GL, RL, BL and WL within a led
+    uint32_t led_size;                      // Bytes of storage for led values
+    uint8_t * volatile led;                 // Dynamically allocated array of LED values in wire order - swapped on commit when double buffered
+    uint8_t *front;                         // LED values being sent - same as led unless double buffered
     ws2812_stateTypeDef led_state;          // LED Transfer state machine
-    uint8_t led_cnt;
+    uint16_t led_cnt;
     uint8_t res_cnt;
-    uint8_t is_dirty;
+    uint8_t res_halves;                     // Halves of zeros in the current reset
+    volatile uint8_t is_dirty;
     uint8_t zero_halves;
+    uint8_t partial;                        // Only send leds up to the last one changed
+    uint16_t send_leds;                     // Leds the next frame has to send
+    uint16_t dirty_leds;                    // Leds changed in the back buffer since the last commit
+    uint16_t frame_leds;                    // Leds sent in the current frame
+    uint8_t idle_stop;                      // Stop the DMA when idle
+    volatile uint8_t stopped;               // DMA stopped until something changes
+    volatile uint32_t idle_since;           // Tick the DMA was stopped
+    GPIO_TypeDef *power_port;               // Led power switch or NULL
+    uint16_t power_pin;
+    GPIO_PinState power_on;                 // Pin level switching the leds on
+    uint32_t power_delay;                   // Ms idle and dark before switching off
+    uint8_t powered;                        // Led power is on
+    uint8_t dark;                           // All leds off when stopped
+    uint8_t dark_checked;
+    ws2812_dmaTypeDef *frame_buffer;        // Pre-encoded frame buffer or NULL when encoding per callback
+    uint32_t frame_size;                    // Size of frame buffer
+    uint8_t zero_frames;                    // Frame buffer passes sent as zeros after a power up
+    uint8_t brightness;                     // Global brightness 0 - 255
+    const uint8_t *gamma;                   // Gamma correction table or NULL for linear
+    uint8_t use_lut;                        // Map led values through lut when encoding
+    uint8_t lut[256];                       // Led value to encoded value lookup table
+    uint16_t *value16;                      // 16 bit led values when dithering or NULL
+    uint8_t *error;                         // Dithering error carried to the next refresh
+    uint8_t *index;                         // Palette index per led in palette mode or NULL
+    uint8_t index_bits;                     // 8 or 4 (two leds per byte, the first in the lower half)
+    uint8_t *palette;                       // Palette colors in wire order - bpp bytes per entry
     uint32_t dma_cbs;
     uint32_t dat_cbs;
+    uint32_t enc_frames;                    // Frames encoded into the frame buffer
+    volatile uint32_t underruns;            // Frames sent again after a callback came too late
+    volatile uint32_t commits;              // Frames committed to the front buffer
+    volatile uint32_t latched;              // Last commit made the front buffer
+    volatile uint32_t displayed;            // Last commit that has been sent and latched by the leds
+    void (*latch_hook)(struct ws2812_handle *ws2812);     // Picks the front buffer on commit instead of copying - see ws2812_rtos.h
+    void (*displayed_hook)(struct ws2812_handle *ws2812); // Called from the DMA callback when a new commit is displayed
+    void *hook_data;
+#ifdef WS2812_STATS
+    ws2812_statsTypeDef stats;
+#endif
 } ws2812_handleTypeDef;
 
+// Statically declare a handle together with storage for its led values and
+// initialize it without any dynamic allocation:
+//   WS2812_DECLARE(ws2812, LEDS);
+//   WS2812_INIT_STATIC(ws2812, &htim4, TIM_CHANNEL_1);
+#define WS2812_DECLARE(name, leds) \
+    static uint8_t name##_led[(leds) * 3]; \
+    ws2812_handleTypeDef name
+#define WS2812_INIT_STATIC(name, timer, channel) \
+    ws2812_init_static(&(name), timer, channel, sizeof(name##_led) / 3, name##_led)
+
+// Same for RGBW leds - the format sets the order of the colors
+#define WS2812_DECLARE_RGBW(name, leds) \
+    static uint8_t name##_led[(leds) * 4]; \
+    ws2812_handleTypeDef name
+#define WS2812_INIT_STATIC_RGBW(name, timer, channel, format) \
+    (ws2812_init_static(&(name), timer, channel, sizeof(name##_led) / 4, name##_led) == WS2812_Ok ? \
+     ws2812_set_format(&(name), format, name##_led) : WS2812_Err)
+
+// Palette mode - a palette index of 8 (or 4) bits per led instead of 3 bytes
+// of led values, expanded to colors when encoding:
+//   WS2812_DECLARE_PALETTE(ws2812, LEDS, 4);
+//   WS2812_INIT_STATIC_PALETTE(ws2812, &htim4, TIM_CHANNEL_1);
+#define WS2812_PALETTE_ENTRIES(bits) (1 << (bits))
+#define WS2812_DECLARE_PALETTE(name, leds, bits) \
+    static const uint16_t name##_leds = (leds); \
+    static const uint8_t name##_bits = (bits); \
+    static uint8_t name##_index[((leds) * (bits) + 7) / 8]; \
+    static uint8_t name##_palette[WS2812_PALETTE_ENTRIES(bits) * 3]; \
+    ws2812_handleTypeDef name
+#define WS2812_INIT_STATIC_PALETTE(name, timer, channel) \
+    ws2812_init_palette(&(name), timer, channel, name##_leds, name##_index, name##_bits, name##_palette)
+
+// Initialize with caller provided storage of leds * 3 bytes for the led values
+ws2812_resultTypeDef ws2812_init_static(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds, uint8_t *led);
+
+// Initialize in palette mode with caller provided storage of leds * bits / 8
+// (rounded up) bytes for the indices and WS2812_PALETTE_ENTRIES(bits) * 3 bytes
+// for the palette.  Bits is 8 or 4.  All leds start out as entry 0 and all
+// entries black.  There are no led values - setLedValues and friends, double
+// buffering, dithering and the FreeRTOS and UART modules are not available.
+ws2812_resultTypeDef ws2812_init_palette(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds,
+        uint8_t *index, uint8_t bits, uint8_t *palette);
+
+#ifndef WS2812_NO_MALLOC
+// Initialize with led values allocated on the heap.  Define WS2812_NO_MALLOC in main.h to leave it out.
 ws2812_resultTypeDef ws2812_init(ws2812_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, uint32_t channel, uint16_t leds);
+#endif
 
-void ws2812_update_buffer(ws2812_handleTypeDef *ws2812, uint16_t *dma_buffer_pointer);
+// Change color order and bytes per led.  Going to 4 bytes per led needs storage
+// of leds * 4 bytes (palette entries * 4 in palette mode), NULL keeps the
+// current one when large enough.  Call right after init - double buffer,
+// dither and frame buffers are sized by it.
+ws2812_resultTypeDef ws2812_set_format(ws2812_handleTypeDef *ws2812, ws2812_formatTypeDef format, uint8_t *led);
+
+void ws2812_update_buffer(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *dma_buffer_pointer);
+
+// To be called from the PWM DMA half complete and complete callbacks
+void ws2812_dma_half_callback(ws2812_handleTypeDef *ws2812);
+void ws2812_dma_full_callback(ws2812_handleTypeDef *ws2812);
+
+// Find the handle running on a timer and the active channel of a callback
+ws2812_handleTypeDef* ws2812_find(TIM_HandleTypeDef *htim);
+
+// To be called from the HAL PWM pulse finished (half) callbacks - dispatches to the right handle.
+// Define WS2812_HAL_CALLBACKS in main.h to have the library implement the HAL callbacks instead.
+void ws2812_tim_half_callback(TIM_HandleTypeDef *htim);
+void ws2812_tim_full_callback(TIM_HandleTypeDef *htim);
+
+// Switch to streaming a pre-encoded frame buffer of WS2812_FRAME_BUFFER_SIZE(leds)
+// (or WS2812_FRAME_BUFFER_SIZE_BPP(leds, 4) for RGBW) entries, NULL to switch back
+ws2812_resultTypeDef ws2812_set_frame_buffer(ws2812_handleTypeDef *ws2812, ws2812_dmaTypeDef *frame_buffer, uint32_t size);
+
+// Add a front buffer of leds * bpp bytes.  Led values are then set in the back
+// buffer and only sent once committed.  The buffers swap on every commit, so
+// ws2812.led changes and every frame has to be drawn in full.  NULL goes back
+// to a single buffer - the one holding the last commit.
+ws2812_resultTypeDef ws2812_set_double_buffer(ws2812_handleTypeDef *ws2812, uint8_t *front);
+
+// Publish the back buffer - it becomes the front buffer between two frames
+ws2812_resultTypeDef ws2812_commit(ws2812_handleTypeDef *ws2812);
+
+// True when the last commit has been sent.  The back buffer should not be touched until then.
+uint8_t ws2812_is_displayed(ws2812_handleTypeDef *ws2812);
+
+// Stop the timer and DMA once a frame has been sent and latched and restart
+// them when something changes - no interrupts at all while idle.  Led changes
+// and commits restart the DMA from the calling context with interrupts
+// disabled for the time it takes to encode the first two halves.
+ws2812_resultTypeDef ws2812_set_idle_stop(ws2812_handleTypeDef *ws2812, uint8_t idle_stop);
+
+// Switch the led power with a GPIO pin - off once the DMA has been stopped
+// (ws2812_set_idle_stop) for delay ms with all leds dark, on again on the next
+// change.  Leds come back after WS2812_POWER_ON_HALVES of zeros with the whole
+// string sent again.  Port NULL leaves the power alone.
+ws2812_resultTypeDef ws2812_set_power_pin(ws2812_handleTypeDef *ws2812, GPIO_TypeDef *port, uint16_t pin, GPIO_PinState on, uint32_t delay);
+
+// To be called from the main loop when using a power pin - switches it off when due
+void ws2812_power_tick(ws2812_handleTypeDef *ws2812);
+
+// Current power state and ms until ws2812_power_tick has something to do -
+// 0 while the DMA is running, WS2812_NEVER when nothing will happen until a
+// change.  The _all versions cover all strings.
+ws2812_powerTypeDef ws2812_power_state(ws2812_handleTypeDef *ws2812);
+ws2812_powerTypeDef ws2812_power_state_all(void);
+uint32_t ws2812_next_activity(ws2812_handleTypeDef *ws2812);
+uint32_t ws2812_next_activity_all(void);
+
+// Called from the DMA callback stopping the DMA - weak, for the application to override
+void ws2812_idle_callback(ws2812_handleTypeDef *ws2812);
+
+// Partial refresh - frames end after the last led changed since the previous
+// frame.  Leds past it keep what they latched last.  Does not apply to frame
+// buffer mode or when dithering.
+ws2812_resultTypeDef ws2812_set_partial(ws2812_handleTypeDef *ws2812, uint8_t partial);
+
+// Scale all leds when encoding - takes effect on the next refresh without touching the led values
+ws2812_resultTypeDef ws2812_set_brightness(ws2812_handleTypeDef *ws2812, uint8_t brightness);
+
+// Gamma correct all leds when encoding using a 256 entry table (gamma_value or one
+// filled by gamma_fill) - NULL for linear.  Combined with brightness in the same lookup.
+ws2812_resultTypeDef ws2812_set_gamma(ws2812_handleTypeDef *ws2812, const uint8_t *gamma);
+
+// Temporal dithering - led values are set as 16 bit (setLedValues16) in value16
+// and the lower 8 bits spread over consecutive refreshes which then run
+// continuously.  Both buffers hold leds * bpp entries, NULL stops dithering.
+// Brightness, gamma and double buffering do not apply to the 16 bit values.
+ws2812_resultTypeDef ws2812_set_dither(ws2812_handleTypeDef *ws2812, uint16_t *value16, uint8_t *error);
+
+// Set values of all 3 leds with 16 bit resolution when dithering
+ws2812_resultTypeDef setLedValues16(ws2812_handleTypeDef *ws2812, uint16_t led, uint16_t r, uint16_t g, uint16_t b);
+
+// Same with the white led of RGBW leds - w is ignored on RGB leds
+ws2812_resultTypeDef setLedValues16W(ws2812_handleTypeDef *ws2812, uint16_t led, uint16_t r, uint16_t g, uint16_t b, uint16_t w);
+
+#ifdef WS2812_STATS
+// Start over collecting statistics
+void ws2812_reset_stats(ws2812_handleTypeDef *ws2812);
+#endif
+
+#ifdef DWT
+// Average cycles needed to encode one led - compare with dithering on and off
+uint32_t ws2812_benchmark(ws2812_handleTypeDef *ws2812);
+#endif
 
 // Set all led values to zero
 ws2812_resultTypeDef zeroLedValues(ws2812_handleTypeDef *ws2812);
 
-// Set a single led value
+// Set a single led value - color is one of GL, RL, BL or WL
 ws2812_resultTypeDef setLedValue(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t color, uint8_t value);
 
 // Set values of all 3 leds
 ws2812_resultTypeDef setLedValues(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t r, uint8_t g, uint8_t b);
 
+// Set values of all 4 leds - white is ignored on RGB leds
+ws2812_resultTypeDef setLedValuesW(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
+// The first leds values have been written straight into ws2812->led - send them
+ws2812_resultTypeDef ws2812_set_changed(ws2812_handleTypeDef *ws2812, uint16_t leds);
+
+// Point a led at a palette entry in palette mode
+ws2812_resultTypeDef setLedIndex(ws2812_handleTypeDef *ws2812, uint16_t led, uint8_t index);
+
+// Change a palette entry - every led using it changes on the next refresh, so
+// color cycling takes a pass over the palette rather than the leds.  White is
+// ignored on RGB leds.
+ws2812_resultTypeDef ws2812_set_palette_color(ws2812_handleTypeDef *ws2812, uint8_t entry, uint8_t r, uint8_t g, uint8_t b);
+ws2812_resultTypeDef ws2812_set_palette_colorW(ws2812_handleTypeDef *ws2812, uint8_t entry, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+
 #endif // _WS2812_H
 /* 
  * vim: ts=4 nowrap
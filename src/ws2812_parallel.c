@@ -0,0 +1,266 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_parallel.c
+ * @brief          : Ws2812 parallel output source
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+#include "ws2812_parallel.h"
+#include "ws2812_transpose.h"
+
+// Registry of initialized ports used for dispatching DMA callbacks
+static ws2812_parallel_handleTypeDef *ws2812_parallel_ports[WS2812_PARALLEL_MAX_PORTS];
+static uint8_t ws2812_parallel_port_cnt = 0;
+
+static ws2812_parallel_handleTypeDef* ws2812_parallel_find(DMA_HandleTypeDef *hdma) {
+    for (uint8_t i = 0; i < ws2812_parallel_port_cnt; i++) {
+        if (ws2812_parallel_ports[i]->timer == hdma->Parent) {
+            return ws2812_parallel_ports[i];
+        }
+    }
+    return NULL;
+}
+
+// Done sending first half of the DMA buffers - these can now safely be updated
+static void ws2812_parallel_dma_half_callback(DMA_HandleTypeDef *hdma) {
+    ws2812_parallel_handleTypeDef *ws2812 = ws2812_parallel_find(hdma);
+    if (ws2812 != NULL) {
+        ws2812_parallel_update_buffer(ws2812, &ws2812->set_buffer[0], &ws2812->data_buffer[0]);
+    }
+}
+
+// Done sending the second half of the DMA buffers - these can now safely be updated
+static void ws2812_parallel_dma_full_callback(DMA_HandleTypeDef *hdma) {
+    ws2812_parallel_handleTypeDef *ws2812 = ws2812_parallel_find(hdma);
+    if (ws2812 != NULL) {
+        ws2812_parallel_update_buffer(ws2812, &ws2812->set_buffer[BUFFER_SIZE], &ws2812->data_buffer[BUFFER_SIZE]);
+    }
+}
+
+// Encode one led of all strings into 24 set and data words
+static inline void ws2812_parallel_encode(ws2812_parallel_handleTypeDef *ws2812, uint16_t led, uint16_t *set_buffer_pointer, uint16_t *data_buffer_pointer) {
+
+    ws2812_transpose((const uint8_t* const*) ws2812->led, ws2812->strands, 3 * led, data_buffer_pointer);
+
+    for (uint8_t i = 0; i < 24; i++) {
+        data_buffer_pointer[i] = ~data_buffer_pointer[i] & ws2812->mask; // Zero bits go low early
+        set_buffer_pointer[i] = ws2812->mask;
+    }
+
+}
+
+/*
+ * Same state machine as the single string version - but each led is turned
+ * into 24 words of one bit per string.  The set buffer is zero while resetting
+ * so the pins stay low.
+ */
+void ws2812_parallel_update_buffer(ws2812_parallel_handleTypeDef *ws2812, uint16_t *set_buffer_pointer, uint16_t *data_buffer_pointer) {
+
+    ++ws2812->dma_cbs;
+
+    if (ws2812->led_state == LED_RES) { // Latch state - 10 or more full 24-bit cycles of zeros
+
+        if (ws2812->zero_halves < 2) {
+            memset(set_buffer_pointer, 0, sizeof(uint16_t) * BUFFER_SIZE); // Nothing goes high
+            ws2812->zero_halves++;
+        }
+
+        ws2812->res_cnt++;
+
+        if (ws2812->res_cnt >= LED_RESET_HALVES) { // done enough reset cycles - move to next state
+            ws2812->led_cnt = 0;
+            if (ws2812->is_dirty) {
+                ws2812->is_dirty = false;
+                ws2812->led_state = LED_DAT;
+            } else {
+                ws2812->led_state = LED_IDL;
+            }
+        }
+
+    } else if (ws2812->led_state == LED_IDL) { // idle state
+
+        if (ws2812->is_dirty) {
+            ws2812->is_dirty = false;
+            ws2812->led_state = LED_DAT;
+        }
+
+    } else { // LED_DAT
+
+        ++ws2812->dat_cbs;
+
+        for (uint8_t l = 0; l < WS2812_LEDS_PER_BUFFER; l++) {
+
+            if (ws2812->led_cnt >= ws2812->leds) { // Past the last led - keep the rest low
+                memset(set_buffer_pointer, 0, sizeof(uint16_t) * 24 * (WS2812_LEDS_PER_BUFFER - l));
+                break;
+            }
+
+            ws2812_parallel_encode(ws2812, ws2812->led_cnt, set_buffer_pointer, data_buffer_pointer);
+
+            data_buffer_pointer += 24;
+            set_buffer_pointer += 24;
+
+            ws2812->led_cnt++;
+
+        }
+
+        if (ws2812->led_cnt >= ws2812->leds) { // reached top
+            ws2812->led_cnt = 0;
+            ws2812->zero_halves = 0;
+            ws2812->res_cnt = 0;
+            ws2812->led_state = LED_RES;
+        }
+
+    }
+
+}
+
+#ifdef DWT
+/*
+ * Average cycles spent encoding one led of all strings, measured with the DWT
+ * cycle counter.  Has to stay well within a bit period of 30 us per led - 2880
+ * cycles at 96 MHz - to leave room for everything else.
+ */
+uint32_t ws2812_parallel_benchmark(ws2812_parallel_handleTypeDef *ws2812) {
+
+    uint16_t set[24], data[24];
+
+    if (ws2812->leds == 0) {
+        return 0;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t start = DWT->CYCCNT;
+
+    for (uint16_t led = 0; led < ws2812->leds; led++) {
+        ws2812_parallel_encode(ws2812, led, set, data);
+    }
+
+    return (DWT->CYCCNT - start) / ws2812->leds;
+
+}
+#endif
+
+ws2812_resultTypeDef setParallelLedValues(ws2812_parallel_handleTypeDef *ws2812, uint8_t strand, uint16_t led, uint8_t r, uint8_t g, uint8_t b) {
+    ws2812_resultTypeDef res = WS2812_Ok;
+    if (strand < ws2812->strands && led < ws2812->leds) {
+        ws2812->led[strand][3 * led + RL] = r;
+        ws2812->led[strand][3 * led + GL] = g;
+        ws2812->led[strand][3 * led + BL] = b;
+        ws2812->is_dirty = true; // Mark buffer dirty
+    } else {
+        res = WS2812_Err;
+    }
+    return res;
+}
+
+// Init again with the same handle or timer replaces the entry
+static ws2812_resultTypeDef ws2812_parallel_register(ws2812_parallel_handleTypeDef *ws2812) {
+    for (uint8_t i = 0; i < ws2812_parallel_port_cnt; i++) {
+        if (ws2812_parallel_ports[i] == ws2812 || ws2812_parallel_ports[i]->timer == ws2812->timer) {
+            ws2812_parallel_ports[i] = ws2812;
+            return WS2812_Ok;
+        }
+    }
+    if (ws2812_parallel_port_cnt >= WS2812_PARALLEL_MAX_PORTS) {
+        return WS2812_Err;
+    }
+    ws2812_parallel_ports[ws2812_parallel_port_cnt++] = ws2812;
+    return WS2812_Ok;
+}
+
+ws2812_resultTypeDef ws2812_parallel_init_static(ws2812_parallel_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, GPIO_TypeDef *port, uint8_t strands, uint16_t leds, uint8_t *led) {
+
+    if (strands == 0 || strands > WS2812_PARALLEL_MAX_STRANDS) {
+        return WS2812_Err;
+    }
+
+    ws2812->timer = timer;
+    ws2812->port = port;
+    ws2812->strands = strands;
+    ws2812->leds = leds;
+    ws2812->mask = (uint16_t) ((1UL << strands) - 1);
+
+    ws2812->led_state = LED_RES;
+    ws2812->is_dirty = 0;
+    ws2812->zero_halves = 2;
+    ws2812->res_cnt = 0;
+    ws2812->led_cnt = 0;
+    ws2812->dma_cbs = ws2812->dat_cbs = 0;
+
+    memset(led, 0, leds * 3 * strands); // Zero it all
+    for (uint8_t n = 0; n < strands; n++) {
+        ws2812->led[n] = &led[n * leds * 3];
+    }
+
+    memset(ws2812->set_buffer, 0, sizeof(ws2812->set_buffer));
+    memset(ws2812->data_buffer, 0, sizeof(ws2812->data_buffer));
+
+    if (ws2812_parallel_register(ws2812) != WS2812_Ok) { // No room for another port
+        return WS2812_Err;
+    }
+
+    // Zero bits go low at LED_OFF, one bits at LED_ON
+    __HAL_TIM_SET_COMPARE(timer, TIM_CHANNEL_1, LED_OFF);
+    __HAL_TIM_SET_COMPARE(timer, TIM_CHANNEL_2, LED_ON);
+
+    // Only the data DMA interrupts - the other two just tag along
+    timer->hdma[TIM_DMA_ID_CC1]->XferHalfCpltCallback = ws2812_parallel_dma_half_callback;
+    timer->hdma[TIM_DMA_ID_CC1]->XferCpltCallback = ws2812_parallel_dma_full_callback;
+
+    HAL_DMA_Start(timer->hdma[TIM_DMA_ID_UPDATE], (uint32_t) ws2812->set_buffer, WS2812_PARALLEL_SET_REG(port), BUFFER_SIZE * 2);
+    HAL_DMA_Start_IT(timer->hdma[TIM_DMA_ID_CC1], (uint32_t) ws2812->data_buffer, WS2812_PARALLEL_RESET_REG(port), BUFFER_SIZE * 2);
+    HAL_DMA_Start(timer->hdma[TIM_DMA_ID_CC2], (uint32_t) &ws2812->mask, WS2812_PARALLEL_RESET_REG(port), BUFFER_SIZE * 2);
+
+    __HAL_TIM_ENABLE_DMA(timer, TIM_DMA_UPDATE | TIM_DMA_CC1 | TIM_DMA_CC2);
+
+    // Update event right away so the first set transfer lines up with the first data transfer
+    HAL_TIM_GenerateEvent(timer, TIM_EVENTSOURCE_UPDATE);
+    __HAL_TIM_ENABLE(timer);
+
+    return WS2812_Ok;
+
+}
+
+#ifndef WS2812_NO_MALLOC
+ws2812_resultTypeDef ws2812_parallel_init(ws2812_parallel_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, GPIO_TypeDef *port, uint8_t strands, uint16_t leds) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    uint8_t *led = malloc(leds * 3 * strands);
+    if (led != NULL) { // Memory for led values of all strings
+        res = ws2812_parallel_init_static(ws2812, timer, port, strands, leds, led);
+        if (res != WS2812_Ok) {
+            free(led);
+        }
+    } else {
+        res = WS2812_Mem;
+    }
+
+    return res;
+
+}
+#endif
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_parallel.h
+ * @brief          : Ws2812 parallel output header
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Drive up to 16 strings from one GPIO port.  One timer running at 800 kHz
+ * triggers three DMA transfers to the port every bit period:
+ *
+ *   update - set all pins high (written from a buffer, zero while resetting)
+ *   CC1    - at LED_OFF pull the pins low that are sending a zero
+ *   CC2    - at LED_ON pull all pins low
+ *
+ * String n is on pin n of the port.  The timer channels need no output and
+ * the DMA for update and CC1 must be circular memory to peripheral with memory
+ * increment, CC2 the same without memory increment.  Memory width is half word,
+ * peripheral width half word (word on the F1).  On the F2/F4 only DMA2 can reach
+ * the GPIO ports, meaning TIM1 or TIM8.
+ */
+
+#ifndef WS2812_PARALLEL_H_
+#define WS2812_PARALLEL_H_
+
+#include "main.h"
+
+#include "ws2812.h"
+
+#define WS2812_PARALLEL_MAX_STRANDS 16
+
+// Maximum number of ports driven at the same time.  Can be overridden in main.h.
+#ifndef WS2812_PARALLEL_MAX_PORTS
+#define WS2812_PARALLEL_MAX_PORTS 2
+#endif
+
+// Registers the DMA is writing - the F1 only allows word access to the port
+// but does have a separate reset register.
+#ifdef STM32F1
+#define WS2812_PARALLEL_SET_REG(port) ((uint32_t) &(port)->BSRR)
+#define WS2812_PARALLEL_RESET_REG(port) ((uint32_t) &(port)->BRR)
+#else
+#define WS2812_PARALLEL_SET_REG(port) ((uint32_t) &(port)->BSRR)
+#define WS2812_PARALLEL_RESET_REG(port) ((uint32_t) &(port)->BSRR + 2)
+#endif
+
+typedef struct {
+    TIM_HandleTypeDef *timer;               // Timer running at 800 kHz - MUST have update, CC1 and CC2 DMA
+    GPIO_TypeDef *port;                     // Port - string n on pin n
+    uint8_t strands;                        // Number of strings
+    uint16_t leds;                          // Number of LEDs on each string
+    uint16_t mask;                          // Pins in use
+    uint8_t *led[WS2812_PARALLEL_MAX_STRANDS]; // LED RGB values of each string
+    uint16_t set_buffer[BUFFER_SIZE * 2];   // Pins to set at the start of each bit
+    uint16_t data_buffer[BUFFER_SIZE * 2];  // Pins to reset at LED_OFF
+    ws2812_stateTypeDef led_state;          // LED Transfer state machine
+    uint16_t led_cnt;
+    uint8_t res_cnt;
+    volatile uint8_t is_dirty;
+    uint8_t zero_halves;
+    uint32_t dma_cbs;
+    uint32_t dat_cbs;
+} ws2812_parallel_handleTypeDef;
+
+// Initialize with caller provided storage of strands * leds * 3 bytes for the led values
+ws2812_resultTypeDef ws2812_parallel_init_static(ws2812_parallel_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, GPIO_TypeDef *port, uint8_t strands, uint16_t leds, uint8_t *led);
+
+#ifndef WS2812_NO_MALLOC
+ws2812_resultTypeDef ws2812_parallel_init(ws2812_parallel_handleTypeDef *ws2812, TIM_HandleTypeDef *timer, GPIO_TypeDef *port, uint8_t strands, uint16_t leds);
+#endif
+
+void ws2812_parallel_update_buffer(ws2812_parallel_handleTypeDef *ws2812, uint16_t *set_buffer_pointer, uint16_t *data_buffer_pointer);
+
+#ifdef DWT
+// Average cycles needed to encode one led of all strings
+uint32_t ws2812_parallel_benchmark(ws2812_parallel_handleTypeDef *ws2812);
+#endif
+
+// Set values of all 3 leds on one string
+ws2812_resultTypeDef setParallelLedValues(ws2812_parallel_handleTypeDef *ws2812, uint8_t strand, uint16_t led, uint8_t r, uint8_t g, uint8_t b);
+
+#endif /* WS2812_PARALLEL_H_ */
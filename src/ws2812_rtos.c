@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_rtos.c
+ * @brief          : Ws2812 FreeRTOS frame handoff source
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+#include "ws2812_rtos.h"
+
+#ifdef WS2812_RTOS
+
+/*
+ * Swap in a new value from a task.  The DMA callback interrupting between the
+ * load and the store clears the exclusive monitor, so the store fails and the
+ * swap is retried with whatever the callback left.
+ */
+static inline uint32_t ws2812_rtos_exchange(volatile uint32_t *ptr, uint32_t value) {
+    uint32_t old;
+#if __CORTEX_M >= 3
+    do {
+        old = __LDREXW(ptr);
+    } while (__STREXW(value, ptr));
+#else // No exclusive access on the Cortex-M0 - keep the callback out for the swap
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    old = *ptr;
+    *ptr = value;
+    __set_PRIMASK(primask);
+#endif
+    return old;
+}
+
+// Called from the DMA callback starting a frame - nothing can interrupt it but a higher priority interrupt
+static void ws2812_rtos_latch(ws2812_handleTypeDef *ws2812) {
+    ws2812_rtosTypeDef *rtos = ws2812->hook_data;
+    uint32_t ready = rtos->ready;
+    if (ready & WS2812_RTOS_FRESH) {
+        rtos->ready = rtos->front;
+        rtos->front = ready & WS2812_RTOS_INDEX;
+        ws2812->front = rtos->buffer[rtos->front];
+    }
+}
+
+static void ws2812_rtos_displayed(ws2812_handleTypeDef *ws2812) {
+    ws2812_rtosTypeDef *rtos = ws2812->hook_data;
+    TaskHandle_t waiting = rtos->waiting;
+    if (waiting != NULL && ws2812_is_displayed(ws2812)) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(waiting, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+ws2812_resultTypeDef ws2812_rtos_init(ws2812_rtosTypeDef *rtos, ws2812_handleTypeDef *ws2812, uint8_t *buffers) {
+
+    if (ws2812->front != ws2812->led || ws2812->value16 != NULL || ws2812->index != NULL) {
+        return WS2812_Err;
+    }
+
+    uint32_t size = ws2812->leds * ws2812->bpp;
+
+    rtos->ws2812 = ws2812;
+    rtos->buffer[0] = ws2812->led;
+    rtos->buffer[1] = buffers;
+    rtos->buffer[2] = &buffers[size];
+    memcpy(rtos->buffer[2], ws2812->led, size);
+    rtos->back = 0;
+    rtos->front = 1;
+    rtos->ready = 2;
+    rtos->waiting = NULL;
+    rtos->skipped = 0;
+
+    // The frame sent is picked from the buffers - changes of skipped frames don't add up
+    ws2812_set_partial(ws2812, false);
+    ws2812_set_double_buffer(ws2812, rtos->buffer[1]);
+
+    ws2812->hook_data = rtos;
+    ws2812->displayed_hook = ws2812_rtos_displayed;
+    ws2812->latch_hook = ws2812_rtos_latch;
+
+    return WS2812_Ok;
+
+}
+
+ws2812_resultTypeDef ws2812_rtos_publish(ws2812_rtosTypeDef *rtos) {
+
+    ws2812_handleTypeDef *ws2812 = rtos->ws2812;
+    uint8_t *drawn = rtos->buffer[rtos->back];
+
+    uint32_t old = ws2812_rtos_exchange(&rtos->ready, rtos->back | WS2812_RTOS_FRESH);
+    if (old & WS2812_RTOS_FRESH) {
+        ++rtos->skipped;
+    }
+
+    // The old ready buffer is ours now - the DMA callback only takes a fresh one
+    rtos->back = old & WS2812_RTOS_INDEX;
+    memcpy(rtos->buffer[rtos->back], drawn, ws2812->leds * ws2812->bpp);
+    ws2812->led = rtos->buffer[rtos->back];
+
+    return ws2812_commit(ws2812);
+
+}
+
+ws2812_resultTypeDef ws2812_rtos_wait_displayed(ws2812_rtosTypeDef *rtos, TickType_t timeout) {
+
+    ws2812_resultTypeDef res = WS2812_Ok;
+
+    rtos->waiting = xTaskGetCurrentTaskHandle(); // Before checking - the callback might display it right now
+
+    while (!ws2812_is_displayed(rtos->ws2812)) {
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            res = WS2812_Err;
+            break;
+        }
+    }
+
+    rtos->waiting = NULL;
+
+    return res;
+
+}
+
+ws2812_resultTypeDef ws2812_rtos_render_init(ws2812_rtos_renderTypeDef *render, ws2812_rtosTypeDef *rtos,
+        void (*fn)(ws2812_handleTypeDef *ws2812, uint32_t frame), uint32_t fps, QueueHandle_t report) {
+
+    if (fps == 0 || fps > configTICK_RATE_HZ) {
+        return WS2812_Err;
+    }
+
+    render->rtos = rtos;
+    render->render = fn;
+    render->period = configTICK_RATE_HZ / fps;
+    render->report = report;
+    render->frame = 0;
+    memset(&render->stats, 0, sizeof(render->stats));
+
+    return WS2812_Ok;
+
+}
+
+void ws2812_rtos_render_task(void *argument) {
+
+    ws2812_rtos_renderTypeDef *render = argument;
+    ws2812_rtos_statsTypeDef *stats = &render->stats;
+    TickType_t period = render->period;
+    TickType_t start = xTaskGetTickCount(); // Start of the period of the frame being rendered
+    TickType_t shown = start;
+    TickType_t reported = start;
+
+    for (;;) {
+
+        render->render(render->rtos->ws2812, render->frame);
+        ws2812_rtos_publish(render->rtos);
+        ws2812_rtos_wait_displayed(render->rtos, period * 4); // Late or not - carry on
+
+        TickType_t now = xTaskGetTickCount();
+        TickType_t took = now - shown;
+        uint32_t jitter = took > period ? took - period : period - took;
+        shown = now;
+
+        ++stats->frames;
+        stats->jitter_sum += jitter;
+        if (jitter > stats->jitter_max) {
+            stats->jitter_max = jitter;
+        }
+
+        ++render->frame;
+        start += period;
+        while ((int32_t) (now - start) >= (int32_t) period) { // Overloaded - drop what is already too late
+            start += period;
+            ++render->frame;
+            ++stats->skipped;
+        }
+
+        if (now - reported >= configTICK_RATE_HZ) {
+            stats->interval = now - reported;
+            stats->fps = stats->frames * 100 * configTICK_RATE_HZ / stats->interval;
+            if (render->report != NULL) {
+                xQueueSend(render->report, stats, 0); // Never wait for the logger
+            }
+            memset(stats, 0, sizeof(*stats));
+            reported = now;
+        }
+
+        if ((int32_t) (start - now) > 0) {
+            vTaskDelay(start - now);
+        }
+
+    }
+
+}
+
+#endif
+
+/*
+ * vim: ts=4 nowrap
+ */
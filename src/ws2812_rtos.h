@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_rtos.h
+ * @brief          : Ws2812 FreeRTOS frame handoff header
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Triple buffered frames for a producer task.  The task draws into the back
+ * buffer (ws2812->led, with setLedValues and friends) and publishes it with
+ * ws2812_rtos_publish, which swaps it with the ready buffer in one exclusive
+ * store.  When a frame starts the DMA callback swaps the ready buffer with
+ * the one it has been sending if a newer frame was published - frames
+ * published faster than they are sent are skipped.  Neither side ever waits
+ * for the other.
+ *
+ * One producer per string - several tasks drawing into the same string have
+ * to take turns themselves.  The DMA interrupt priority must be at or below
+ * configMAX_SYSCALL_INTERRUPT_PRIORITY for the task notifications.
+ *
+ * Define WS2812_RTOS in main.h to build it.
+ */
+
+#ifndef WS2812_RTOS_H_
+#define WS2812_RTOS_H_
+
+#include "main.h"
+
+#include "ws2812.h"
+
+#ifdef WS2812_RTOS
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define WS2812_RTOS_INDEX 0x03              // Buffer index in ready
+#define WS2812_RTOS_FRESH 0x04              // Ready buffer has not been picked up yet
+
+typedef struct {
+    ws2812_handleTypeDef *ws2812;
+    uint8_t *buffer[3];                     // Each leds * bpp bytes
+    volatile uint32_t ready;                // Last published buffer and WS2812_RTOS_FRESH
+    uint8_t back;                           // Buffer drawn by the producer
+    uint8_t front;                          // Buffer sent by the DMA
+    volatile TaskHandle_t waiting;          // Task in ws2812_rtos_wait_displayed or NULL
+    uint32_t skipped;                       // Frames replaced before they were sent
+} ws2812_rtosTypeDef;
+
+// Render task statistics - sent to the report queue once a second
+typedef struct {
+    uint32_t fps;                           // Frames displayed per second * 100
+    uint32_t frames;                        // Frames displayed in the interval
+    uint32_t skipped;                       // Frames not rendered for running late
+    uint32_t interval;                      // Ticks covered
+    uint32_t jitter_max;                    // Largest difference between a frame time and the period in ticks
+    uint32_t jitter_sum;                    // Sum of the differences - divided by frames for the average
+} ws2812_rtos_statsTypeDef;
+
+typedef struct {
+    ws2812_rtosTypeDef *rtos;
+    void (*render)(ws2812_handleTypeDef *ws2812, uint32_t frame); // Draws a frame into the back buffer
+    TickType_t period;                      // Ticks per frame
+    QueueHandle_t report;                   // Queue of ws2812_rtos_statsTypeDef or NULL
+    uint32_t frame;                         // Frame number - skipped frames count as well
+    ws2812_rtos_statsTypeDef stats;         // Being collected
+} ws2812_rtos_renderTypeDef;
+
+// Two more buffers of leds * bpp bytes besides the led values of the handle
+#define WS2812_RTOS_DECLARE(name, leds) \
+    static uint8_t name##_buffers[2 * (leds) * WS2812_MAX_BPP]; \
+    ws2812_rtosTypeDef name
+#define WS2812_RTOS_INIT_STATIC(name, ws2812) \
+    ws2812_rtos_init(&(name), ws2812, name##_buffers)
+
+// Take over a single buffered handle with buffers of 2 * leds * bpp bytes.
+// Call before any producer runs - partial refresh is switched off.
+ws2812_resultTypeDef ws2812_rtos_init(ws2812_rtosTypeDef *rtos, ws2812_handleTypeDef *ws2812, uint8_t *buffers);
+
+// Publish the back buffer.  Drawing goes on in a copy of it.
+ws2812_resultTypeDef ws2812_rtos_publish(ws2812_rtosTypeDef *rtos);
+
+// Block until the last frame published has been sent and latched by the leds
+ws2812_resultTypeDef ws2812_rtos_wait_displayed(ws2812_rtosTypeDef *rtos, TickType_t timeout);
+
+// Render fps frames a second with render(ws2812, frame) as the producer of
+// rtos.  The period is rounded to whole ticks.
+ws2812_resultTypeDef ws2812_rtos_render_init(ws2812_rtos_renderTypeDef *render, ws2812_rtosTypeDef *rtos,
+        void (*fn)(ws2812_handleTypeDef *ws2812, uint32_t frame), uint32_t fps, QueueHandle_t report);
+
+// Task function taking the render handle as argument - never returns.  Each
+// frame is rendered at the start of its period and published, then the task
+// waits for it to be displayed.  Frames whose period has passed by then are
+// skipped - the frame number keeps counting so animations keep their speed.
+void ws2812_rtos_render_task(void *argument);
+
+#endif
+
+#endif /* WS2812_RTOS_H_ */
+
+/*
+ * vim: ts=4 nowrap
+ */
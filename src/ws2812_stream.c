@@ -0,0 +1,402 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_stream.c
+ * @brief          : Ws2812 Adalight and TPM2 UART receiver source
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "main.h"
+
+#include "ws2812.h"
+#include "ws2812_stream.h"
+
+#ifdef WS2812_STREAM
+
+// Registry of receiving UARTs used for dispatching callbacks
+static ws2812_streamTypeDef *ws2812_streams[WS2812_STREAM_MAX];
+static uint8_t ws2812_stream_cnt = 0;
+
+static ws2812_streamTypeDef* ws2812_stream_find(UART_HandleTypeDef *huart) {
+    for (uint8_t i = 0; i < ws2812_stream_cnt; i++) {
+        if (ws2812_streams[i]->uart == huart) {
+            return ws2812_streams[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Double buffered - the frame goes into the back buffer, starting off from the
+ * frame before so delta ops and leds past the end of the data have a base.
+ * A frame committed but not sent yet is already in the back buffer and is
+ * replaced by this one rather than swapped out under the parser.
+ */
+static void ws2812_stream_back_buffer(ws2812_handleTypeDef *ws2812) {
+
+    if (ws2812->front == ws2812->led) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint8_t pending = ws2812->latched != ws2812->commits;
+    ws2812->latched = ws2812->commits; // Nothing to swap until the next commit
+    __set_PRIMASK(primask);
+
+    if (!pending) {
+        memcpy(ws2812->led, ws2812->front, ws2812->leds * ws2812->bpp);
+    }
+
+}
+
+// Header complete - get ready for the data
+static void ws2812_stream_start_frame(ws2812_streamTypeDef *stream) {
+
+    ws2812_handleTypeDef *ws2812 = stream->ws2812;
+
+    if (stream->header_len == 6) { // Adalight sends the number of leds - 1
+        stream->data_len = 3 * (((stream->header[3] << 8) | stream->header[4]) + 1);
+        stream->state = WS2812_STREAM_DATA;
+    } else {
+        stream->data_len = (stream->header[2] << 8) | stream->header[3];
+        switch (stream->header[1]) {
+        case WS2812_STREAM_TPM2_DATA:
+            stream->state = WS2812_STREAM_DATA;
+            break;
+        case WS2812_STREAM_TPM2_DELTA:
+            stream->state = WS2812_STREAM_DELTA;
+            break;
+        case WS2812_STREAM_TPM2_PALETTE:
+            stream->state = WS2812_STREAM_PALETTE;
+            break;
+        default:
+            stream->state = WS2812_STREAM_SKIP;
+        }
+    }
+
+    stream->data_cnt = 0;
+    stream->pos = 0;
+    stream->changed = 0;
+    stream->color = 0;
+    stream->op_cnt = 0;
+    stream->map[0] = ws2812->offset[RL];
+    stream->map[1] = ws2812->offset[GL];
+    stream->map[2] = ws2812->offset[BL];
+
+    if (stream->state == WS2812_STREAM_DATA || stream->state == WS2812_STREAM_DELTA) {
+        ws2812_stream_back_buffer(ws2812);
+    }
+
+}
+
+// Take a header byte - false when it can't be one
+static uint8_t ws2812_stream_header(ws2812_streamTypeDef *stream, uint8_t byte) {
+
+    uint8_t *header = stream->header;
+    uint8_t cnt = stream->header_cnt;
+
+    if (stream->header_len == 6) {
+        if ((cnt == 1 && byte != 'd') || (cnt == 2 && byte != 'a') || (cnt == 5 && byte != (header[3] ^ header[4] ^ 0x55))) {
+            return false;
+        }
+    }
+
+    header[stream->header_cnt++] = byte;
+
+    if (stream->header_cnt == stream->header_len) {
+        ws2812_stream_start_frame(stream);
+    }
+
+    return true;
+
+}
+
+// Write pixel data into the led values - bytes past the end of the string are dropped
+static void ws2812_stream_data(ws2812_streamTypeDef *stream, const uint8_t *data, uint32_t len) {
+
+    ws2812_handleTypeDef *ws2812 = stream->ws2812;
+    uint8_t *led = ws2812->led;
+    uint32_t end = ws2812->leds * ws2812->bpp;
+    uint32_t pos = stream->pos;
+    uint8_t color = stream->color;
+
+    for (uint32_t i = 0; i < len && pos < end; i++) {
+        led[pos + stream->map[color]] = data[i];
+        if (++color == 3) {
+            color = 0;
+            pos += ws2812->bpp;
+        }
+    }
+
+    stream->pos = pos;
+    stream->changed = pos;
+    stream->color = color;
+
+}
+
+// One led of a delta frame
+static inline void ws2812_stream_put(ws2812_streamTypeDef *stream, const uint8_t *rgb) {
+    ws2812_handleTypeDef *ws2812 = stream->ws2812;
+    if (stream->pos < ws2812->leds * ws2812->bpp) {
+        uint8_t *led = &ws2812->led[stream->pos];
+        led[stream->map[0]] = rgb[0];
+        led[stream->map[1]] = rgb[1];
+        led[stream->map[2]] = rgb[2];
+        stream->pos += ws2812->bpp;
+        stream->changed = stream->pos;
+    }
+}
+
+// Decode delta frame ops - an op byte expands to WS2812_STREAM_OP_MAX leds at most
+static void ws2812_stream_delta(ws2812_streamTypeDef *stream, const uint8_t *data, uint32_t len) {
+
+    for (uint32_t i = 0; i < len; i++) {
+
+        uint8_t byte = data[i];
+
+        if (stream->op_cnt == 0) { // Next op
+            stream->op = byte & WS2812_STREAM_OP_MASK;
+            stream->op_cnt = (byte & ~WS2812_STREAM_OP_MASK) + 1;
+            stream->color = 0;
+            if (stream->op == WS2812_STREAM_OP_SKIP) {
+                stream->pos += stream->op_cnt * stream->ws2812->bpp;
+                stream->op_cnt = 0;
+            }
+            continue;
+        }
+
+        switch (stream->op) {
+        case WS2812_STREAM_OP_RUN:
+            stream->rgb[stream->color++] = byte;
+            if (stream->color == 3) {
+                while (stream->op_cnt > 0) {
+                    ws2812_stream_put(stream, stream->rgb);
+                    --stream->op_cnt;
+                }
+            }
+            break;
+        case WS2812_STREAM_OP_LITERAL:
+            stream->rgb[stream->color++] = byte;
+            if (stream->color == 3) {
+                ws2812_stream_put(stream, stream->rgb);
+                stream->color = 0;
+                --stream->op_cnt;
+            }
+            break;
+        default: // Palette index
+#if WS2812_STREAM_PALETTE_SIZE < 256
+            if (byte >= WS2812_STREAM_PALETTE_SIZE) { // No such entry - leave the led alone
+                stream->pos += stream->ws2812->bpp;
+                --stream->op_cnt;
+                break;
+            }
+#endif
+            ws2812_stream_put(stream, stream->palette[byte]);
+            --stream->op_cnt;
+        }
+
+    }
+
+}
+
+// Palette entries from the first index on
+static void ws2812_stream_palette(ws2812_streamTypeDef *stream, const uint8_t *data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t cnt = stream->data_cnt + i;
+        if (cnt == 0) {
+            stream->pos = data[i]; // Entry being written
+        } else if (stream->pos < WS2812_STREAM_PALETTE_SIZE) {
+            stream->palette[stream->pos][(cnt - 1) % 3] = data[i];
+            if ((cnt - 1) % 3 == 2) {
+                stream->pos++;
+            }
+        }
+    }
+}
+
+// A whole frame is in - send it
+static void ws2812_stream_frame(ws2812_streamTypeDef *stream) {
+
+    ws2812_handleTypeDef *ws2812 = stream->ws2812;
+    uint32_t leds = stream->changed / ws2812->bpp;
+
+    ws2812_set_changed(ws2812, leds);
+    if (ws2812->front != ws2812->led) {
+        ws2812_commit(ws2812);
+    }
+
+    ++stream->frames;
+
+}
+
+void ws2812_stream_parse(ws2812_streamTypeDef *stream, const uint8_t *data, uint32_t len) {
+
+    uint32_t i = 0;
+
+    while (i < len) {
+
+        switch (stream->state) {
+        case WS2812_STREAM_SYNC:
+            if (data[i] == 'A') {
+                stream->header_len = 6;
+            } else if (data[i] == WS2812_STREAM_TPM2_START) {
+                stream->header_len = 4;
+            } else { // Not the start of anything
+                ++i;
+                break;
+            }
+            stream->header[0] = data[i++];
+            stream->header_cnt = 1;
+            stream->state = WS2812_STREAM_HEADER;
+            break;
+        case WS2812_STREAM_HEADER:
+            if (ws2812_stream_header(stream, data[i])) {
+                ++i;
+            } else { // Have another look at it as the start of a frame
+                ++stream->errors;
+                stream->state = WS2812_STREAM_SYNC;
+            }
+            break;
+        case WS2812_STREAM_DATA:
+        case WS2812_STREAM_DELTA:
+        case WS2812_STREAM_PALETTE:
+        case WS2812_STREAM_SKIP: {
+            uint32_t n = stream->data_len - stream->data_cnt;
+            if (n > len - i) {
+                n = len - i;
+            }
+            if (stream->state == WS2812_STREAM_DATA) {
+                ws2812_stream_data(stream, &data[i], n);
+            } else if (stream->state == WS2812_STREAM_DELTA) {
+                ws2812_stream_delta(stream, &data[i], n);
+            } else if (stream->state == WS2812_STREAM_PALETTE) {
+                ws2812_stream_palette(stream, &data[i], n);
+            }
+            i += n;
+            stream->data_cnt += n;
+            if (stream->data_cnt == stream->data_len) {
+                if (stream->header_len == 6) { // Adalight has no end byte
+                    ws2812_stream_frame(stream);
+                    stream->state = WS2812_STREAM_SYNC;
+                } else {
+                    stream->state = WS2812_STREAM_END;
+                }
+            }
+            break;
+        }
+        case WS2812_STREAM_END:
+            if (data[i++] != WS2812_STREAM_TPM2_END) {
+                ++stream->errors;
+            } else if (stream->header[1] == WS2812_STREAM_TPM2_DATA || stream->header[1] == WS2812_STREAM_TPM2_DELTA) {
+                ws2812_stream_frame(stream);
+            }
+            stream->state = WS2812_STREAM_SYNC;
+            break;
+        }
+
+    }
+
+}
+
+static ws2812_resultTypeDef ws2812_stream_start(ws2812_streamTypeDef *stream) {
+    stream->tail = 0;
+    stream->state = WS2812_STREAM_SYNC;
+    if (HAL_UARTEx_ReceiveToIdle_DMA(stream->uart, stream->buffer, WS2812_STREAM_BUFFER_SIZE) != HAL_OK) {
+        return WS2812_Err;
+    }
+    return WS2812_Ok;
+}
+
+// Size is how far the DMA has got into the buffer
+void ws2812_stream_rx_callback(UART_HandleTypeDef *huart, uint16_t size) {
+
+    ws2812_streamTypeDef *stream = ws2812_stream_find(huart);
+
+    if (stream == NULL || size == stream->tail) {
+        return;
+    }
+
+    if (size > stream->tail) {
+        ws2812_stream_parse(stream, &stream->buffer[stream->tail], size - stream->tail);
+    } else { // Wrapped around since
+        ws2812_stream_parse(stream, &stream->buffer[stream->tail], WS2812_STREAM_BUFFER_SIZE - stream->tail);
+        ws2812_stream_parse(stream, stream->buffer, size);
+    }
+
+    stream->tail = size == WS2812_STREAM_BUFFER_SIZE ? 0 : size;
+
+}
+
+// The HAL stops receiving on errors - start over with the next frame
+void ws2812_stream_error_callback(UART_HandleTypeDef *huart) {
+    ws2812_streamTypeDef *stream = ws2812_stream_find(huart);
+    if (stream != NULL) {
+        ++stream->errors;
+        ws2812_stream_start(stream);
+    }
+}
+
+#ifdef WS2812_HAL_CALLBACKS
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+    ws2812_stream_rx_callback(huart, Size);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    ws2812_stream_error_callback(huart);
+}
+#endif
+
+ws2812_resultTypeDef ws2812_stream_init(ws2812_streamTypeDef *stream, ws2812_handleTypeDef *ws2812, UART_HandleTypeDef *uart) {
+
+    if (ws2812->led == NULL) { // Palette mode - nowhere to put the pixels
+        return WS2812_Err;
+    }
+
+    if (ws2812->latch_hook != NULL) { // Frames have to be handed over through whatever set the hook (ws2812_rtos_publish)
+        return WS2812_Err;
+    }
+
+    if (ws2812->value16 != NULL) { // Dithering sends the 16 bit values - the pixels would never show
+        return WS2812_Err;
+    }
+
+    stream->ws2812 = ws2812;
+    stream->uart = uart;
+    stream->frames = 0;
+    stream->errors = 0;
+
+    // Replace whatever was receiving on the same UART before
+    uint8_t i = 0;
+    while (i < ws2812_stream_cnt && ws2812_streams[i]->uart != uart) {
+        i++;
+    }
+    if (i == ws2812_stream_cnt) {
+        if (ws2812_stream_cnt >= WS2812_STREAM_MAX) {
+            return WS2812_Err;
+        }
+        ws2812_stream_cnt++;
+    }
+    ws2812_streams[i] = stream;
+
+    return ws2812_stream_start(stream);
+
+}
+
+#endif
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,141 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_stream.h
+ * @brief          : Ws2812 Adalight and TPM2 UART receiver header
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Receive frames from a PC over a UART straight into the led values.  The
+ * UART receive DMA must be circular - it runs continuously into a buffer in
+ * the handle and HAL_UARTEx_RxEventCallback (half, full and idle line) hands
+ * whatever arrived to the parser.  No interrupt per byte.  Two protocols,
+ * recognized by their first byte:
+ *
+ *   Adalight - 'A' 'd' 'a' count-1 (hi, lo) checksum (hi ^ lo ^ 0x55) rgb...
+ *   TPM2     - 0xc9 type (0xda data) size (hi, lo) rgb... 0x36
+ *
+ * Pixels are written into ws2812->led as they arrive and sent when the frame
+ * is complete.  Double buffered the back buffer is filled with the frame
+ * shown at the start of every frame (a copy of leds * bpp bytes) and
+ * committed at the end, so frames do not tear - a frame still waiting to be
+ * sent is replaced by the next one.  Data for more leds than the string has
+ * is dropped.
+ *
+ * Two more TPM2 packet types carry compressed frames:
+ *
+ *   0xdb palette - first index, then rgb for that and the following entries
+ *   0xdc delta   - ops from the first led on, each one byte with the number
+ *                  of leds - 1 (up to 64) in the lower 6 bits:
+ *
+ *     00nnnnnn          leds unchanged from the previous frame
+ *     01nnnnnn rgb      leds all of the same color
+ *     10nnnnnn rgb...   leds of their own color
+ *     11nnnnnn i...     leds of palette entry i
+ *
+ * Leds after the last op keep their values as well.  Any op byte expands to
+ * at most 64 leds, so the work per received byte is bounded.
+ *
+ * Define WS2812_STREAM in main.h to build it.
+ */
+
+#ifndef WS2812_STREAM_H_
+#define WS2812_STREAM_H_
+
+#include "main.h"
+
+#include "ws2812.h"
+
+#ifdef WS2812_STREAM
+
+// Circular receive buffer - parsed every half.  Can be overridden in main.h.
+#ifndef WS2812_STREAM_BUFFER_SIZE
+#define WS2812_STREAM_BUFFER_SIZE 512
+#endif
+
+// Maximum number of UARTs receiving at the same time.  Can be overridden in main.h.
+#ifndef WS2812_STREAM_MAX
+#define WS2812_STREAM_MAX 2
+#endif
+
+#define WS2812_STREAM_TPM2_START 0xc9
+#define WS2812_STREAM_TPM2_DATA 0xda
+#define WS2812_STREAM_TPM2_PALETTE 0xdb
+#define WS2812_STREAM_TPM2_DELTA 0xdc
+#define WS2812_STREAM_TPM2_END 0x36
+
+// Delta frame ops
+#define WS2812_STREAM_OP_SKIP 0x00
+#define WS2812_STREAM_OP_RUN 0x40
+#define WS2812_STREAM_OP_LITERAL 0x80
+#define WS2812_STREAM_OP_INDEX 0xc0
+#define WS2812_STREAM_OP_MASK 0xc0
+#define WS2812_STREAM_OP_MAX 64             // Leds per op
+
+// Palette entries for delta frames.  Can be overridden in main.h.
+#ifndef WS2812_STREAM_PALETTE_SIZE
+#define WS2812_STREAM_PALETTE_SIZE 256
+#endif
+
+typedef enum {
+    WS2812_STREAM_SYNC = 0,                 // Looking for the start of a frame
+    WS2812_STREAM_HEADER,
+    WS2812_STREAM_DATA,                     // Pixels
+    WS2812_STREAM_DELTA,                    // Delta frame ops
+    WS2812_STREAM_PALETTE,                  // Palette entries
+    WS2812_STREAM_SKIP,                     // Data of a TPM2 packet which isn't a frame
+    WS2812_STREAM_END                       // TPM2 end byte
+} ws2812_stream_stateTypeDef;
+
+typedef struct {
+    ws2812_handleTypeDef *ws2812;
+    UART_HandleTypeDef *uart;
+    uint8_t buffer[WS2812_STREAM_BUFFER_SIZE]; // Circular DMA buffer
+    uint16_t tail;                          // Next byte to parse
+    ws2812_stream_stateTypeDef state;
+    uint8_t header[6];
+    uint8_t header_len;                     // 6 for Adalight, 4 for TPM2
+    uint8_t header_cnt;
+    uint32_t data_len;                      // Bytes of data in the frame
+    uint32_t data_cnt;                      // Bytes parsed so far
+    uint32_t pos;                           // Led being written times bpp
+    uint8_t color;                          // Color of the next byte - 0 to 2 for r, g and b
+    uint8_t map[3];                         // Position of r, g and b within a led
+    uint8_t op;                             // Delta op being decoded
+    uint8_t op_cnt;                         // Leds left in it - 0 when the next byte is an op
+    uint8_t rgb[3];                         // Color being received
+    uint32_t changed;                       // One past the last led written times bpp
+    uint8_t palette[WS2812_STREAM_PALETTE_SIZE][3];
+    uint32_t frames;                        // Frames received
+    uint32_t errors;                        // Bad headers, checksums, end bytes and UART errors
+} ws2812_streamTypeDef;
+
+// Start receiving on a UART with a circular receive DMA.  Not on handles in
+// palette mode, dithering or taken over by ws2812_rtos_init.
+ws2812_resultTypeDef ws2812_stream_init(ws2812_streamTypeDef *stream, ws2812_handleTypeDef *ws2812, UART_HandleTypeDef *uart);
+
+// To be called from HAL_UARTEx_RxEventCallback and HAL_UART_ErrorCallback.  Define
+// WS2812_HAL_CALLBACKS in main.h to have the library implement both instead.
+void ws2812_stream_rx_callback(UART_HandleTypeDef *huart, uint16_t size);
+void ws2812_stream_error_callback(UART_HandleTypeDef *huart);
+
+// Parse received bytes - no HAL involved
+void ws2812_stream_parse(ws2812_streamTypeDef *stream, const uint8_t *data, uint32_t len);
+
+#endif
+
+#endif /* WS2812_STREAM_H_ */
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,123 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_transpose.c
+ * @brief          : Ws2812 bit transpose source
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdint.h>
+
+#include "ws2812_transpose.h"
+
+/*
+ * Transpose the 8x8 bit matrix held in x (rows 0 - 3) and y (rows 4 - 7) using
+ * the shift and mask (SWAR) swaps from Hacker's Delight - 2x2, then 4x4 blocks
+ * within the words and finally the 4x4 blocks between them.  About 30
+ * instructions with no branches against 64 bit extractions for the naive loop.
+ */
+static inline void ws2812_transpose_core(uint32_t *px, uint32_t *py) {
+
+    uint32_t x = *px, y = *py, t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    *py = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    *px = t;
+
+}
+
+// Rows are packed in reverse so strand n ends up in bit n rather than bit 7 - n
+#define TRANSPOSE_PACK(a, b, c, d) (((uint32_t) (a) << 24) | ((uint32_t) (b) << 16) | ((uint32_t) (c) << 8) | (uint32_t) (d))
+
+void ws2812_transpose8x8(const uint8_t in[8], uint8_t out[8]) {
+
+    uint32_t x = TRANSPOSE_PACK(in[7], in[6], in[5], in[4]);
+    uint32_t y = TRANSPOSE_PACK(in[3], in[2], in[1], in[0]);
+
+    ws2812_transpose_core(&x, &y);
+
+    out[0] = x >> 24;
+    out[1] = x >> 16;
+    out[2] = x >> 8;
+    out[3] = x;
+    out[4] = y >> 24;
+    out[5] = y >> 16;
+    out[6] = y >> 8;
+    out[7] = y;
+
+}
+
+void ws2812_transpose16x8(const uint8_t in[16], uint16_t out[8]) {
+
+    uint32_t xl = TRANSPOSE_PACK(in[7], in[6], in[5], in[4]);
+    uint32_t yl = TRANSPOSE_PACK(in[3], in[2], in[1], in[0]);
+    uint32_t xh = TRANSPOSE_PACK(in[15], in[14], in[13], in[12]);
+    uint32_t yh = TRANSPOSE_PACK(in[11], in[10], in[9], in[8]);
+
+    ws2812_transpose_core(&xl, &yl);
+    ws2812_transpose_core(&xh, &yh);
+
+    // Strands 0 - 7 in the low byte, 8 - 15 in the high byte
+    out[0] = ((xh >> 16) & 0xFF00) | ((xl >> 24) & 0x00FF);
+    out[1] = ((xh >> 8) & 0xFF00) | ((xl >> 16) & 0x00FF);
+    out[2] = (xh & 0xFF00) | ((xl >> 8) & 0x00FF);
+    out[3] = ((xh << 8) & 0xFF00) | (xl & 0x00FF);
+    out[4] = ((yh >> 16) & 0xFF00) | ((yl >> 24) & 0x00FF);
+    out[5] = ((yh >> 8) & 0xFF00) | ((yl >> 16) & 0x00FF);
+    out[6] = (yh & 0xFF00) | ((yl >> 8) & 0x00FF);
+    out[7] = ((yh << 8) & 0xFF00) | (yl & 0x00FF);
+
+}
+
+void ws2812_transpose(const uint8_t *const led[], uint8_t strands, uint32_t offset, uint16_t *out) {
+
+    uint8_t in[16] = { 0 }; // Missing strands transpose as zeros
+
+    for (uint8_t c = 0; c < 3; c++) { // The 3 color bytes of the led
+
+        for (uint8_t n = 0; n < strands; n++) {
+            in[n] = led[n][offset + c];
+        }
+
+        if (strands <= 8) {
+
+            uint8_t bits[8];
+
+            ws2812_transpose8x8(in, bits);
+
+            for (uint8_t b = 0; b < 8; b++) {
+                out[b] = bits[b];
+            }
+
+        } else {
+            ws2812_transpose16x8(in, out);
+        }
+
+        out += 8;
+
+    }
+
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
@@ -0,0 +1,32 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_transpose.h
+ * @brief          : Ws2812 bit transpose header
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef WS2812_TRANSPOSE_H_
+#define WS2812_TRANSPOSE_H_
+
+#include <stdint.h>
+
+// Bit matrix transposes - in[n] is the byte of strand n and bit n of out[b] is
+// bit b (msb first) of in[n].
+void ws2812_transpose8x8(const uint8_t in[8], uint8_t out[8]);
+void ws2812_transpose16x8(const uint8_t in[16], uint16_t out[8]);
+
+// Turn one led (3 bytes) of up to 16 strands into 24 words - bit n of word b
+// is bit b (msb first) of strand n.  Kept free of any HAL dependency.
+void ws2812_transpose(const uint8_t *const led[], uint8_t strands, uint32_t offset, uint16_t *out);
+
+#endif /* WS2812_TRANSPOSE_H_ */
@@ -0,0 +1,189 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_verify.c
+ * @brief          : Ws2812 bitstream decoder and timing verifier source
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ws2812_verify.h"
+
+const ws2812_verify_timingTypeDef ws2812_verify_ws2812b = {
+    .t0h_min = 250,
+    .t0h_max = 550,
+    .t1h_min = 650,
+    .t1h_max = 950,
+    .low_min = 300,
+    .low_max = 5000,    // Leds are known to hold on to a lot more but not how much more
+    .reset_min = 50000
+};
+
+void ws2812_verify_init(ws2812_verifyTypeDef *verify, const ws2812_verify_timingTypeDef *timing, uint8_t *frame, uint32_t size, ws2812_verify_latchedTypeDef latched) {
+    memset(verify, 0, sizeof(ws2812_verifyTypeDef));
+    verify->timing = timing;
+    verify->frame = frame;
+    verify->size = size;
+    verify->latched = latched;
+}
+
+static void ws2812_verify_error(ws2812_verifyTypeDef *verify) {
+    if (ws2812_verify_errors(verify) == 0) {
+        verify->first_error = verify->time;
+    }
+}
+
+static void ws2812_verify_latch(ws2812_verifyTypeDef *verify) {
+    ++verify->frames;
+    if (verify->latched != NULL) {
+        verify->latched(verify, verify->bits);
+    }
+    verify->bits = 0;
+}
+
+// Decode one pulse and the low following it
+static inline void ws2812_verify_pulse(ws2812_verifyTypeDef *verify, uint32_t high, uint32_t low) {
+
+    const ws2812_verify_timingTypeDef *timing = verify->timing;
+    uint8_t bit;
+
+    if (high >= timing->t1h_min && high <= timing->t1h_max) {
+        bit = 1;
+    } else if (high >= timing->t0h_min && high <= timing->t0h_max) {
+        bit = 0;
+    } else {
+        ws2812_verify_error(verify);
+        ++verify->bad_high;
+        bit = high > (timing->t0h_max + timing->t1h_min) / 2; // What a led would most likely make of it
+    }
+
+    if (verify->bits / 8 < verify->size) {
+        uint8_t *byte = &verify->frame[verify->bits / 8];
+        *byte = (*byte << 1) | bit;
+    }
+    ++verify->bits;
+
+    if (low >= timing->reset_min) {
+        ws2812_verify_latch(verify);
+    } else if (low < timing->low_min || low > timing->low_max) {
+        ws2812_verify_error(verify);
+        ++verify->bad_low;
+    }
+
+}
+
+/*
+ * Every compare value is one period starting with high for the compare value
+ * counts.  A pulse is decoded once the next one starts or the line has been low
+ * long enough to latch.
+ */
+void ws2812_verify_ccr(ws2812_verifyTypeDef *verify, const uint16_t *ccr, uint32_t count, uint16_t period, uint32_t period_ns) {
+
+    uint32_t reset_min = verify->timing->reset_min;
+
+    for (uint32_t i = 0; i < count; i++) {
+
+        uint32_t high = ccr[i] >= period ? period_ns : ccr[i] * period_ns / period;
+
+        if (high > 0) {
+            if (verify->high > 0) {
+                ws2812_verify_pulse(verify, verify->high, verify->low);
+            }
+            verify->high = high;
+            verify->low = period_ns - high;
+        } else if (verify->high > 0) {
+            verify->low += period_ns;
+            if (verify->low >= reset_min) { // Latched - no need to wait for the next pulse
+                ws2812_verify_pulse(verify, verify->high, verify->low);
+                verify->high = 0;
+            }
+        }
+
+        verify->time += period_ns;
+
+    }
+
+}
+
+void ws2812_verify_edge(ws2812_verifyTypeDef *verify, uint64_t time, uint8_t level) {
+
+    level = level != 0;
+    if (level == verify->level) {
+        return;
+    }
+
+    uint64_t duration = time - verify->last;
+    if (duration > UINT32_MAX) {
+        duration = UINT32_MAX;
+    }
+
+    verify->time = time;
+
+    if (level) { // Rising - the low after the pulse is done
+        if (verify->high > 0) {
+            ws2812_verify_pulse(verify, verify->high, duration);
+        }
+        verify->high = 0;
+    } else { // Falling - the pulse is done
+        verify->high = duration > 0 ? duration : 1;
+    }
+
+    verify->last = time;
+    verify->level = level;
+
+}
+
+void ws2812_verify_csv(ws2812_verifyTypeDef *verify, const char *line) {
+
+    char *end;
+    double seconds = strtod(line, &end);
+    if (end == line || *end != ',') {
+        return; // Header or something else
+    }
+
+    const char *value = end + 1;
+    long level = strtol(value, &end, 10);
+    if (end == value) {
+        return;
+    }
+
+    int64_t time = seconds * 1e9 + (seconds < 0 ? -0.5 : 0.5);
+
+    if (!verify->started) { // Captures might start before the trigger - count from the first line
+        verify->started = 1;
+        verify->origin = time;
+        verify->level = level != 0;
+        return;
+    }
+
+    ws2812_verify_edge(verify, time - verify->origin, level);
+
+}
+
+void ws2812_verify_flush(ws2812_verifyTypeDef *verify) {
+    if (verify->high > 0 && verify->level == 0) {
+        ws2812_verify_pulse(verify, verify->high, verify->timing->reset_min);
+        verify->high = 0;
+    } else if (verify->bits > 0) {
+        ws2812_verify_latch(verify);
+    }
+}
+
+uint32_t ws2812_verify_errors(ws2812_verifyTypeDef *verify) {
+    return verify->bad_high + verify->bad_low;
+}
+
+/*
+ * vim: ts=4 nowrap
+ */
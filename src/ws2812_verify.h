@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file           : ws2812_verify.h
+ * @brief          : Ws2812 bitstream decoder and timing verifier header
+ ******************************************************************************
+ * @attention
+ *
+ * Copyright (c) 2024 Lars Boegild Thomsen <lbthomsen@gmail.com>.
+ * All rights reserved.
+ *
+ * This software is licensed under terms that can be found in the LICENSE file
+ * in the root directory of this software component.
+ * If no LICENSE file comes with this software, it is provided AS-IS.
+ *
+ ******************************************************************************
+ */
+
+#ifndef WS2812_VERIFY_H_
+#define WS2812_VERIFY_H_
+
+#include <stdint.h>
+
+// Decodes a captured or simulated output the way the leds would and counts
+// anything outside the timing.  No HAL dependencies - meant for a host build
+// next to a simulation or a logic analyzer capture.
+
+// Timing limits in ns
+typedef struct {
+    uint32_t t0h_min, t0h_max;              // High time of a 0 bit
+    uint32_t t1h_min, t1h_max;              // High time of a 1 bit
+    uint32_t low_min;                       // Shortest low between two bits
+    uint32_t low_max;                       // Longest low between two bits not latching the leds
+    uint32_t reset_min;                     // Low time latching the leds
+} ws2812_verify_timingTypeDef;
+
+// WS2812B datasheet limits (T0H 0.4 us, T1H 0.8 us +/- 150 ns, reset 50 us)
+extern const ws2812_verify_timingTypeDef ws2812_verify_ws2812b;
+
+typedef struct ws2812_verifyTypeDef ws2812_verifyTypeDef;
+
+// Called for every frame latched - the bits of the frame are in frame
+typedef void (*ws2812_verify_latchedTypeDef)(ws2812_verifyTypeDef *verify, uint32_t bits);
+
+struct ws2812_verifyTypeDef {
+    const ws2812_verify_timingTypeDef *timing;
+    ws2812_verify_latchedTypeDef latched;
+    uint8_t *frame;                         // Decoded frame - msb first like on the wire
+    uint32_t size;                          // Bytes of frame - bits past it are counted but dropped
+    uint32_t bits;                          // Bits of the current frame
+    uint32_t high;                          // High time of the pulse being measured
+    uint32_t low;                           // Low time following it
+    uint64_t time;                          // Time of the input so far
+    uint64_t last;                          // Time of the last edge (edge input)
+    uint8_t level;                          // Level after the last edge (edge input)
+    uint8_t started;                        // Got the first line (csv input)
+    int64_t origin;                         // Time of the first line (csv input)
+    uint32_t frames;                        // Frames latched
+    uint32_t bad_high;                      // Pulses that are neither a 0 nor a 1
+    uint32_t bad_low;                       // Lows too short or long enough to maybe latch early
+    uint64_t first_error;                   // Time of the first timing violation
+};
+
+void ws2812_verify_init(ws2812_verifyTypeDef *verify, const ws2812_verify_timingTypeDef *timing, uint8_t *frame, uint32_t size, ws2812_verify_latchedTypeDef latched);
+
+// Feed compare values of a PWM running period counts per period_ns
+void ws2812_verify_ccr(ws2812_verifyTypeDef *verify, const uint16_t *ccr, uint32_t count, uint16_t period, uint32_t period_ns);
+
+// Feed a level change at time ns (or a logic analyzer line of "time in seconds,level" - other lines are skipped)
+void ws2812_verify_edge(ws2812_verifyTypeDef *verify, uint64_t time, uint8_t level);
+void ws2812_verify_csv(ws2812_verifyTypeDef *verify, const char *line);
+
+// End of input - the line is assumed to stay low so the last frame is latched
+void ws2812_verify_flush(ws2812_verifyTypeDef *verify);
+
+// Number of timing violations
+uint32_t ws2812_verify_errors(ws2812_verifyTypeDef *verify);
+
+#endif /* WS2812_VERIFY_H_ */
+/*
+ * vim: ts=4 nowrap
+ */